@@ -0,0 +1,79 @@
+# benchmark matrix: MCNC cases and generated GSRC-like instances for several alphas and seeds
+# records runtime, moves/sec, cost, area, wirelength and legality of every run to log/bench/results.csv
+# and flags regressions against bench/baseline.csv, exiting with 1 if there is any
+# usage: ./bench.sh [--save-baseline] [extra fp options], e.g. ./bench.sh --save-baseline --engine seqpair
+# the matrix and tolerances are overridden by the environment, e.g. SIZES="10 100" TIME_LIMIT=10 ./bench.sh
+make bin/fp bin/gen_bench || exit 1
+ALPHAS=${ALPHAS:-"0.25 0.5 0.75"}
+SEEDS=${SEEDS:-"1 2"}
+SIZES=${SIZES:-"10 30 50 100 200 300 500 1000 2000"}
+TIME_LIMIT=${TIME_LIMIT:-60}
+COST_TOL=${COST_TOL:-0.02} # relative cost increase
+SPEED_TOL=${SPEED_TOL:-0.1} # relative moves/sec decrease
+RUNTIME_TOL=${RUNTIME_TOL:-0.2} # relative runtime increase
+BASELINE=bench/baseline.csv
+OUT=log/bench
+save_baseline=0
+if [ "$1" = "--save-baseline" ]; then
+    save_baseline=1
+    shift
+fi
+mkdir -p $OUT/input
+
+cases=""
+for case in xerox hp apte ami33 ami49; do
+    if [ -f ../input_pa2/$case.block ]; then cases="$cases ../input_pa2/$case"
+    else echo "Skip $case: ../input_pa2/$case.block not found"
+    fi
+done
+for size in $SIZES; do
+    ./bin/gen_bench $size $size $OUT/input/gsrc_n$size || exit 1
+    cases="$cases $OUT/input/gsrc_n$size"
+done
+
+results=$OUT/results.csv
+echo "case,alpha,seed,runtime,moves_per_sec,cost,area,wirelength,legal" > $results
+for path in $cases; do
+    case=$(basename $path)
+    for alpha in $ALPHAS; do
+        for seed in $SEEDS; do
+            run=$OUT/${case}_a${alpha}_s$seed
+            ./bin/fp $alpha $path.block $path.nets $run.rpt --seed $seed --time-limit $TIME_LIMIT --trace $run "$@" > $run.log
+            # legality by the result checker
+            if ./bin/fp $alpha $path.block $path.nets $run.rpt --check > /dev/null; then legal=1; else legal=0; fi
+            moves=$(sed -n 's/.*"moves_per_sec": \([^,]*\),.*/\1/p' $run.json)
+            # cost, wirelength, area and runtime of the report
+            cost=$(sed -n 1p $run.rpt)
+            wirelength=$(sed -n 2p $run.rpt)
+            area=$(sed -n 3p $run.rpt)
+            runtime=$(sed -n 5p $run.rpt)
+            echo "$case,$alpha,$seed,$runtime,$moves,$cost,$area,$wirelength,$legal" | tee -a $results
+        done
+    done
+done
+
+if [ $save_baseline = 1 ]; then
+    cp $results $BASELINE
+    echo "Saved baseline $BASELINE"
+    exit 0
+fi
+if [ ! -f $BASELINE ]; then
+    echo "No baseline $BASELINE to compare with, save one by ./bench.sh --save-baseline"
+    exit 0
+fi
+# runs are matched by case, alpha and seed
+awk -F, -v cost_tol=$COST_TOL -v speed_tol=$SPEED_TOL -v runtime_tol=$RUNTIME_TOL '
+NR==FNR { if(FNR>1) baseline[$1","$2","$3] = $0; next }
+FNR>1 && ($1","$2","$3) in baseline {
+    run = $1" alpha "$2" seed "$3
+    split(baseline[$1","$2","$3], b, ",")
+    if(b[9]==1 && $9==0){ print "Regression " run ": illegal, legal in baseline"; num++ }
+    if($6 > b[6]*(1+cost_tol)){ print "Regression " run ": cost " $6 ", baseline " b[6]; num++ }
+    if($5 < b[5]*(1-speed_tol)){ print "Regression " run ": " $5 " moves/sec, baseline " b[5]; num++ }
+    # runs of a few seconds are too noisy to compare
+    if($4 > b[4]*(1+runtime_tol) && $4 > b[4]+1){ print "Regression " run ": runtime " $4 " sec, baseline " b[4]; num++ }
+}
+END {
+    if(num){ print num " regressions against the baseline"; exit 1 }
+    print "No regression against the baseline"
+}' $BASELINE $results
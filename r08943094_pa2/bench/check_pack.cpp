@@ -0,0 +1,49 @@
+#include <iostream>
+#include <string>
+#include "../src/BSTree.h"
+using namespace std;
+
+#ifndef DEBUG
+#error "check_pack needs the consistency checks of a DEBUG build of BSTree.cpp"
+#endif
+
+// randomized equivalence check of incremental B*-tree packing: every complete pack is checked
+// by BSTEngine::check_packing against a full packing of the tree with a brute-force skyline,
+// the highest top among the blocks placed before within the range of each block, which stays the
+// reference of the contour; operations are accepted or undone at random and some packings stop
+// early at a random area bound, as in SA
+int main(int argc, char** argv)
+{
+    int num_trees = argc > 1 ? stoi(argv[1]) : 200;
+    int num_operations = argc > 2 ? stoi(argv[2]) : 500;
+    Xoshiro256 rand_gen(1);
+    long long num_checked = 0, num_stopped = 0;
+    for (int t = 0; t < num_trees; t++) {
+        int num_blocks = 2 + rand_gen.below(t % 2 ? 300 : 30);
+        BlockList blocks;
+        long long total_width = 0;
+        for (int i = 0; i < num_blocks; i++) {
+            int w = 1 + rand_gen.below(100), h = 1 + rand_gen.below(100);
+            blocks.push_back(new Block(i, "b" + to_string(i), w, h));
+            total_width += max(w, h);
+        }
+        BSTEngine engine(&blocks);
+        engine.initial_floorplan(1 + rand_gen.below(total_width));
+        int chip_width, chip_height;
+        vector<int> moved_blocks;
+        engine.pack(chip_width, chip_height, moved_blocks, HUGE_VAL);
+        double area = (double)chip_width * chip_height;
+        for (int i = 0; i < num_operations; i++) {
+            engine.random_operation(rand_gen);
+            double max_area = rand_gen.below(4) ? HUGE_VAL : area * rand_gen.uniform();
+            moved_blocks.clear();
+            if (engine.pack(chip_width, chip_height, moved_blocks, max_area)) num_checked++;
+            else num_stopped++;
+            if (rand_gen.below(2)) engine.undo_operation();
+        }
+        for (Block *block : blocks) delete block;
+    }
+    cout << "Incremental packing matches full packing in " << num_checked << " packings of " << num_trees
+         << " random trees (" << num_stopped << " stopped early)" << endl;
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+using namespace std;
+
+// GSRC-like hard block instance: block areas are log-uniform over two orders of magnitude
+// with aspect ratios up to 3, the square outline has 15% white space, terminals sit on
+// the outline, and most nets connect two or three pins of which at least one is a block
+int main(int argc, char** argv)
+{
+    if (argc != 4) {
+        cerr << "Usage: ./gen_bench <num blocks> <seed> <output prefix>" << endl;
+        cerr << "writes <output prefix>.block and <output prefix>.nets" << endl;
+        exit(1);
+    }
+    int num_blocks = stoi(argv[1]);
+    if (num_blocks < 2) {
+        cerr << "Number of blocks has to be at least 2" << endl;
+        exit(1);
+    }
+    mt19937 rand_gen(stoul(argv[2]));
+    string prefix = argv[3];
+    int num_terminals = 2*num_blocks + 50;
+    int num_nets = 4*num_blocks + 80;
+    double white_space = 0.15;
+
+    uniform_real_distribution<double> unif(0., 1.);
+    vector<int> widths, heights;
+    double total_area = 0.;
+    for (int i = 0; i < num_blocks; i++) {
+        double area = 100. * pow(100., unif(rand_gen));
+        double ar = pow(3., 2.*unif(rand_gen) - 1.);
+        int width = max(1, (int)round(sqrt(area / ar)));
+        int height = max(1, (int)round(sqrt(area * ar)));
+        widths.push_back(width);
+        heights.push_back(height);
+        total_area += (double)width * height;
+    }
+    int outline = ceil(sqrt(total_area * (1. + white_space)));
+
+    fstream block_file(prefix + ".block", ios::out);
+    fstream net_file(prefix + ".nets", ios::out);
+    if (!block_file || !net_file) {
+        cerr << "Cannot open the output files \"" << prefix << ".block\" and \"" << prefix << ".nets\"" << endl;
+        exit(1);
+    }
+    block_file << "Outline: " << outline << " " << outline << "\n";
+    block_file << "NumBlocks: " << num_blocks << "\n";
+    block_file << "NumTerminals: " << num_terminals << "\n";
+    for (int i = 0; i < num_blocks; i++) {
+        block_file << "bk" << i << " " << widths[i] << " " << heights[i] << "\n";
+    }
+    // terminals are spread along the four sides of the outline
+    uniform_int_distribution<int> along(0, outline);
+    for (int i = 0; i < num_terminals; i++) {
+        int pos = along(rand_gen);
+        int x, y;
+        switch (i % 4) {
+            case 0: x = pos; y = 0; break;
+            case 1: x = outline; y = pos; break;
+            case 2: x = pos; y = outline; break;
+            default: x = 0; y = pos; break;
+        }
+        block_file << "p" << i << " terminal " << x << " " << y << "\n";
+    }
+
+    uniform_int_distribution<int> pick_block(0, num_blocks - 1);
+    uniform_int_distribution<int> pick_pin(0, num_blocks + num_terminals - 1);
+    net_file << "NumNets: " << num_nets << "\n";
+    for (int n = 0; n < num_nets; n++) {
+        double p = unif(rand_gen);
+        int degree = p < 0.6 ? 2 : p < 0.8 ? 3 : p < 0.95 ? 4 + (int)(3. * unif(rand_gen)) : 7 + (int)(10. * unif(rand_gen));
+        degree = min(degree, num_blocks + num_terminals);
+        vector<int> pins(1, pick_block(rand_gen));
+        while ((int)pins.size() < degree) {
+            int pin = pick_pin(rand_gen);
+            if (find(pins.begin(), pins.end(), pin) == pins.end()) pins.push_back(pin);
+        }
+        net_file << "NetDegree: " << degree << "\n";
+        for (int pin : pins) {
+            if (pin < num_blocks) net_file << "bk" << pin << "\n";
+            else net_file << "p" << pin - num_blocks << "\n";
+        }
+    }
+    return 0;
+}
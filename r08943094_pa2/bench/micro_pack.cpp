@@ -0,0 +1,72 @@
+#include <iostream>
+#include <chrono>
+#include <climits>
+#include <string>
+#include "../src/BSTree.h"
+using namespace std;
+
+// microseconds per call of fn over about a second
+template<typename Fn>
+double measure(Fn fn)
+{
+    long long num_calls = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double elapsed = 0.;
+    while (elapsed < 1.) {
+        fn();
+        num_calls++;
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    return elapsed * 1e6 / num_calls;
+}
+
+// packing throughput of the B*-tree on random blocks: the skyline of a full packing replays every
+// block of the packed tree on an empty contour, and an SA move packs after a random operation
+// that is undone afterwards as a rejected move, resuming from the first changed node
+int main(int argc, char** argv)
+{
+    vector<int> sizes;
+    for (int i = 1; i < argc; i++) sizes.push_back(stoi(argv[i]));
+    if (sizes.empty()) sizes = {49, 300, 2000};
+    cout << fixed;
+    cout.precision(2);
+    for (int num_blocks : sizes) {
+        Xoshiro256 rand_gen(1);
+        BlockList blocks;
+        long long total_width = 0;
+        for (int i = 0; i < num_blocks; i++) {
+            int w = 10 + rand_gen.below(90), h = 10 + rand_gen.below(90);
+            blocks.push_back(new Block(i, "b" + to_string(i), w, h));
+            total_width += max(w, h);
+        }
+        BSTEngine engine(&blocks);
+        engine.initial_floorplan(total_width / 10);
+        int chip_width, chip_height;
+        vector<int> moved_blocks, order;
+        engine.pack(chip_width, chip_height, moved_blocks, HUGE_VAL);
+        engine.get_order(order);
+
+        Contour contour;
+        double full_us = measure([&]{
+            contour.reset();
+            for (int id : order) {
+                contour.find_blk_y(blocks[id], blocks[id]->get_x());
+                contour.update(blocks[id]);
+            }
+        });
+        long long num_packs = 0;
+        long long placed_before = engine.get_num_placed();
+        double incremental_us = measure([&]{
+            engine.random_operation(rand_gen);
+            moved_blocks.clear();
+            engine.pack(chip_width, chip_height, moved_blocks, HUGE_VAL);
+            engine.undo_operation();
+            num_packs++;
+        });
+        double placed_per_pack = (double)(engine.get_num_placed() - placed_before) / num_packs;
+        cout << num_blocks << " blocks: skyline of a full packing " << full_us << " us, SA move with incremental packing "
+             << incremental_us << " us placing " << placed_per_pack << " blocks" << endl;
+        for (Block *block : blocks) delete block;
+    }
+    return 0;
+}
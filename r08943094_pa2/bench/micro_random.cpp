@@ -0,0 +1,50 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+#include "../src/rng.h"
+using namespace std;
+
+// nanoseconds per call of fn, the sum of its results keeps the calls from being optimized out
+template<typename Fn>
+void measure(const string &name, long long num_calls, Fn fn)
+{
+    double sum = 0.;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (long long i = 0; i < num_calls; i++) sum += fn();
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / num_calls;
+    cout << name << ": " << ns << " ns/call (checksum " << sum << ")" << endl;
+}
+
+// random draws and acceptance margins of the SA inner loop with the previous standard
+// generator and distribution against xoshiro256** and the interpolated logarithm
+int main(int argc, char** argv)
+{
+    long long num_calls = argc > 1 ? stoll(argv[1]) : 100000000;
+    int num_blocks = 300;
+    double T = 0.01;
+    cout << fixed;
+
+    default_random_engine std_engine(1);
+    uniform_real_distribution<double> unif(0., 0.999999);
+    StdRandom std_random(1);
+    Xoshiro256 xoshiro(1);
+
+    cout << "block index in [0," << num_blocks << ")\n";
+    measure("  default_random_engine + uniform_real_distribution", num_calls, [&]{return (int)(unif(std_engine) * num_blocks);});
+    measure("  Xoshiro256::below", num_calls, [&]{return xoshiro.below(num_blocks);});
+    cout << "uniform double\n";
+    measure("  StdRandom::uniform", num_calls, [&]{return std_random.uniform();});
+    measure("  Xoshiro256::uniform", num_calls, [&]{return xoshiro.uniform();});
+    cout << "acceptance margin -T*ln(u)\n";
+    measure("  log", num_calls, [&]{return -T * log(1. - xoshiro.uniform());});
+    measure("  fast_neg_log", num_calls, [&]{return T * fast_neg_log(1. - xoshiro.uniform());});
+    // largest error of the interpolation over a fine grid of u
+    double max_error = 0.;
+    for (int i = 1; i <= 1000000; i++) {
+        double u = i / 1000000.;
+        max_error = max(max_error, abs(fast_neg_log(u) + log(u)));
+    }
+    cout << "largest error of fast_neg_log: " << scientific << max_error << endl;
+    return 0;
+}
@@ -0,0 +1,11 @@
+# compare B*-tree and sequence pair engines on the benchmark cases
+# usage: ./bench_engine.sh [extra fp options], e.g. ./bench_engine.sh --time-limit 60
+make
+mkdir -p ../output_pa2 log
+for case in xerox hp apte ami33 ami49; do
+    for engine in bstree seqpair; do
+        ./bin/fp 0.5 ../input_pa2/$case.block ../input_pa2/$case.nets ../output_pa2/$case.$engine.rpt --engine $engine "$@" > log/$case.$engine.log
+        # cost, wirelength, area, chip dimension and runtime of the report
+        echo "$case $engine $(head -5 ../output_pa2/$case.$engine.rpt | tr '\n' ' ')"
+    done
+done
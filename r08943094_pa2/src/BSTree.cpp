@@ -1,111 +1,184 @@
 #include "BSTree.h"
+#include <queue>
 
 using namespace std;
 
-bool BST::remove(Node *node)
+bool BST::remove(int id)
 {
-    if(node->left && node->right || node==get_root()) return false;
-    Node *parent = node->parent;
-    if(!node->left && !node->right){
-        if(parent->left == node) parent->left = nullptr;
-        else parent->right = nullptr;
-    }
-    else if(node->left){
-        if(parent->left == node) parent->left = node->left;
-        else if(parent->right == node) parent->right = node->left;
-        else{
-            cerr<<"Error: node parent does not point to node\n";
-            exit(1);
-        }
-        node->left->parent = parent;
-    }
+    if(left[id]!=-1 && right[id]!=-1 || id==get_root()) return false;
+    int p = parent[id];
+    int child = left[id]!=-1 ? left[id] : right[id];
+    hash ^= link_key(id);
+    if(child!=-1) hash ^= link_key(child);
+    if(left[p] == id) left[p] = child;
+    else if(right[p] == id) right[p] = child;
     else{
-        if(parent->left == node) parent->left = node->right;
-        else if(parent->right == node) parent->right = node->right;
-        else{
-            cerr<<"Error: node parent does not point to node\n";
-            exit(1);
-        }
-        node->right->parent = parent;
+        cerr<<"Error: node parent does not point to node\n";
+        exit(1);
     }
-    node->parent = nullptr;
-    node->left = nullptr;
-    node->right = nullptr;
+    if(child!=-1) parent[child] = p;
+    parent[id] = -1;
+    left[id] = -1;
+    right[id] = -1;
+    hash ^= link_key(id);
+    if(child!=-1) hash ^= link_key(child);
     return true;
 }
 
-bool BST::append(Node *parent, Node *node, bool LR)
+bool BST::append(int parent_id, int id, bool LR)
 {
-    if(parent==nullptr){
-        set_root(node);
+    if(parent_id==-1){
+        set_root(id);
         return true;
     }
     if(LR){
-        if(parent->right) return false;
-        parent->right = node;
+        if(right[parent_id]!=-1) return false;
+        right[parent_id] = id;
     }
     else{
-        if(parent->left) return false;
-        parent->left = node;
+        if(left[parent_id]!=-1) return false;
+        left[parent_id] = id;
     }
-    node->parent = parent;
+    hash ^= link_key(id);
+    parent[id] = parent_id;
+    hash ^= link_key(id);
     return true;
 }
 
-void BST::rotate(Node *node)
+// splice a detached node into the LR child slot of parent
+// the original child becomes the child_LR child of the node
+void BST::insert(int parent_id, int id, bool LR, bool child_LR)
+{
+    int &slot = LR ? right[parent_id] : left[parent_id];
+    int child = slot;
+    hash ^= link_key(id);
+    if(child!=-1) hash ^= link_key(child);
+    slot = id;
+    parent[id] = parent_id;
+    hash ^= link_key(id);
+    if(child==-1) return;
+    if(child_LR) right[id] = child;
+    else left[id] = child;
+    parent[child] = id;
+    hash ^= link_key(child);
+}
+
+void BST::rotate(int id)
 {
-    node->orien = !node->orien;
+    orien[id] = !orien[id];
+    hash ^= orien_key(id);
+}
+
+// exchange the positions of two blocks, orientation stays with the block
+void BST::swap(int id1, int id2)
+{
+    int p1 = parent[id1], l1 = left[id1], r1 = right[id1];
+    int p2 = parent[id2], l2 = left[id2], r2 = right[id2];
+    // links change for the two nodes and their children
+    int linked[6] = {id1, id2, l1, r1, l2, r2};
+    for(int k = 0; k<6; k++){
+        if(linked[k]!=-1 && (k<2 || linked[k]!=id1 && linked[k]!=id2)) hash ^= link_key(linked[k]);
+    }
+    // relink neighbors
+    if(p1!=-1 && p1==p2){
+        std::swap(left[p1], right[p1]);
+    }
+    else{
+        if(p1!=-1 && p1!=id2) (left[p1]==id1 ? left[p1] : right[p1]) = id2;
+        if(p2!=-1 && p2!=id1) (left[p2]==id2 ? left[p2] : right[p2]) = id1;
+    }
+    if(l1!=-1 && l1!=id2) parent[l1] = id2;
+    if(r1!=-1 && r1!=id2) parent[r1] = id2;
+    if(l2!=-1 && l2!=id1) parent[l2] = id1;
+    if(r2!=-1 && r2!=id1) parent[r2] = id1;
+    // relink the two nodes, links between them are mirrored
+    auto mirror = [id1, id2](int id){return id==id1 ? id2 : id==id2 ? id1 : id;};
+    parent[id1] = mirror(p2); left[id1] = mirror(l2); right[id1] = mirror(r2);
+    parent[id2] = mirror(p1); left[id2] = mirror(l1); right[id2] = mirror(r1);
+    if(root==id1) root = id2;
+    else if(root==id2) root = id1;
+    for(int k = 0; k<6; k++){
+        if(linked[k]!=-1 && (k<2 || linked[k]!=id1 && linked[k]!=id2)) hash ^= link_key(linked[k]);
+    }
 }
 
-void BST::swap(Node *n1, Node *n2)
+// hash computed from scratch to check the incremental one
+uint64_t BST::calculate_hash() const
 {
-    int tmp_id = n1->id;
-    bool tmp_orien = n1->orien;
-    n1->id = n2->id;
-    n1->orien = n2->orien;
-    n2->id = tmp_id;
-    n2->orien = tmp_orien;
+    uint64_t val = 0;
+    for(int id = 0; id<get_num_nodes(); id++){
+        val ^= link_key(id);
+        if(orien[id]) val ^= orien_key(id);
+    }
+    return val;
 }
 
 // replace an entire tree by another tree
-void BST::replace(BST *tree)
+void BST::replace(const BST &tree)
 {
-    // delete all nodes
-    delete_tree(get_root());
-    // copy all nodes
-    copy(tree->get_root(), nullptr);
-    // annotate cost
-    set_cost(tree->get_cost());
-    // print(root);
+    // arrays are copied in place without reallocation
+    *this = tree;
 }
 
-void BST::delete_tree(Node *node)
+// pre-order traversal with an explicit stack
+void BST::get_dfs_order(vector<int> &order, vector<int> &stack) const
 {
-    if(!node) return;
-    delete_tree(node->left);
-    delete_tree(node->right);
-    delete node;
+    order.clear();
+    stack.clear();
+    if(root!=-1) stack.push_back(root);
+    while(!stack.empty()){
+        int id = stack.back();
+        stack.pop_back();
+        order.push_back(id);
+        if(right[id]!=-1) stack.push_back(right[id]);
+        if(left[id]!=-1) stack.push_back(left[id]);
+    }
+}
+
+// root, then children and orientation of every node
+void BST::write(ostream &output) const
+{
+    output<<root<<"\n";
+    for(int id = 0; id<get_num_nodes(); id++){
+        output<<left[id]<<" "<<right[id]<<" "<<(int)orien[id]<<"\n";
+    }
 }
 
-void BST::copy(Node *ori_node, Node *new_parent, bool LR)
+// a tree written by write, false unless every node is reached from the root exactly once
+bool BST::read(istream &input, int num_nodes)
 {
-    if(!ori_node) return;
-    Node *new_node = new Node(ori_node);
-    append(new_parent, new_node, LR);
-    copy(ori_node->left, new_node, false);
-    copy(ori_node->right, new_node, true);
+    init(num_nodes);
+    if(!(input>>root) || root<0 || root>=num_nodes) return false;
+    for(int id = 0; id<num_nodes; id++){
+        int o;
+        if(!(input>>left[id]>>right[id]>>o)) return false;
+        orien[id] = o!=0;
+    }
+    for(int id = 0; id<num_nodes; id++){
+        for(int child : {left[id], right[id]}){
+            if(child==-1) continue;
+            if(child<0 || child>=num_nodes || child==root || parent[child]!=-1) return false;
+            parent[child] = id;
+        }
+    }
+    vector<int> order, stack;
+    get_dfs_order(order, stack);
+    if((int)order.size()!=num_nodes) return false;
+    hash = calculate_hash();
+    return true;
 }
 
-void BST::print(Node *node)
+void BST::print() const
 {
-    if(!node) return;
-    cout<<"Node #"<<node->id<<":\n";
-    if(node->parent) cout<<"parent= #"<<node->parent->id<<"\n";
-    if(node->left) cout<<"left= #"<<node->left->id<<"\n";
-    if(node->right) cout<<"right= #"<<node->right->id<<"\n";
-    cout<<endl;
-    print(node->left);
-    print(node->right);
+    vector<int> order, stack;
+    get_dfs_order(order, stack);
+    for(int id : order){
+        cout<<"Node #"<<id<<":\n";
+        if(parent[id]!=-1) cout<<"parent= #"<<parent[id]<<"\n";
+        if(left[id]!=-1) cout<<"left= #"<<left[id]<<"\n";
+        if(right[id]!=-1) cout<<"right= #"<<right[id]<<"\n";
+        cout<<endl;
+    }
 }
 
 int Contour::find_blk_y(Block *b, int x)
@@ -113,118 +186,511 @@ int Contour::find_blk_y(Block *b, int x)
     // block x has to be correct
     int blk_x1 = x;
     int blk_x2 = blk_x1 + b->get_width();
-    // if there's a corner within the range of the block horizontally
+    // the highest segment within the range of the block horizontally
+    map<int, int>::iterator it = prev(_hor.upper_bound(blk_x1));
     int max_y = 0;
-    bool corner_in_hor_range = false;
-    for(vector<XY>::iterator it = _hor.begin(); it!=_hor.end(); it++){
-        XY corner = *it;
-        if(corner.first < blk_x1) continue;
-        if(corner.first > blk_x2) break;
-        if(it!=_hor.end()-1 && corner.first==blk_x1 && corner.first==(it+1)->first && corner.second>(it+1)->second) continue;
-        if(it!=_hor.begin() && corner.first==blk_x2 && corner.first==(it-1)->first && corner.second>(it-1)->second) break;
-        max_y = max(max_y, corner.second);
-        corner_in_hor_range = true;
-    }
-    // if there's no corner within the range of the block horizontally
-    if(!corner_in_hor_range){
-        for(XY corner : _hor){
-            if(corner.first > blk_x1) break;
-            max_y = corner.second;
-        }
+    for(; it!=_hor.end() && it->first<blk_x2; it++){
+        max_y = max(max_y, it->second);
     }
     return max_y;
 }
 
 void Contour::update(Block *b)
 {
-    // new corners
     int x1, y1, x2, y2;
     tie(x1, y1) = b->get_low_xy();
     tie(x2, y2) = b->get_top_xy();
-    // update horizontal corner
-    // newly added horizontal corners
-    vector<XY> new_corners;
-    new_corners.emplace_back(x1,y1);
-    new_corners.emplace_back(x1,y2);
-    new_corners.emplace_back(x2,y2);
-    new_corners.emplace_back(x2,y1);
-    // merge with current corner list
-    vector<XY>::iterator it = _hor.begin();
+    // height right after the block
+    map<int, int>::iterator it = prev(_hor.upper_bound(x2));
+    int right_height = it->second;
+    // remove segments covered by the block
+    it = _hor.upper_bound(x1);
+    while(it!=_hor.end() && it->first<=x2){
+        map<int, int>::iterator next_it = next(it);
+        erase_segment(it);
+        it = next_it;
+    }
+    // raise the block segment and reconnect with the contour on the right
+    set_segment(x1, y2);
+    set_segment(x2, right_height);
+    // merge with neighbors of the same height
+    it = _hor.find(x2);
+    if(it->second==y2) erase_segment(it);
+    it = _hor.find(x1);
+    if(it!=_hor.begin() && prev(it)->second==y2) erase_segment(it);
+    // update max height
+    if(y2 > max_height){
+        journal.push_back(Change{-1, max_height, true});
+        max_height = y2;
+    }
+}
+
+void Contour::set_segment(int x, int height)
+{
+    map<int, int>::iterator it = _hor.find(x);
+    if(it==_hor.end()){
+        journal.push_back(Change{x, 0, false});
+        _hor[x] = height;
+    }
+    else{
+        journal.push_back(Change{x, it->second, true});
+        it->second = height;
+    }
+}
+
+void Contour::erase_segment(map<int, int>::iterator it)
+{
+    journal.push_back(Change{it->first, it->second, true});
+    _hor.erase(it);
+}
+
+// undo all changes after the mark
+void Contour::rollback(int mark)
+{
+    while(journal.size() > mark){
+        Change &change = journal.back();
+        if(change.x==-1) max_height = change.height;
+        else if(change.existed) _hor[change.x] = change.height;
+        else _hor.erase(change.x);
+        journal.pop_back();
+    }
+}
+
+void Contour::check()
+{
+    // check horizontal
+    if(_hor.begin()->first!=0){
+        cerr<<"Error horizontal contour: contour does not start from origin\n";
+        print();
+        exit(1);
+    }
+    map<int, int>::iterator it = next(_hor.begin());
     while(it!=_hor.end()){
-        XY xy = *it;
-        // remove corners lying within the interval
-        if(xy.first>x1 && xy.first<x2) it = _hor.erase(it)-1;
-        if(xy.first>=x2) break;
+        if(it->second == prev(it)->second){
+            cerr<<"Error horizontal contour: adjacent segments of the same height\n";
+            print();
+            exit(1);
+        }
         it++;
     }
-    // insert an extra corner to connect with current contour
-    if(it->second < new_corners.back().second){
-        new_corners.emplace_back(x2,it->second);
+}
+
+vector<int> BSTEngine::get_highest_placed_block_ids(int chip_height) const
+{
+    // traverse the b*-tree with BFS
+    vector<int> block_ids;
+    queue<int> q;
+    q.push(current_bst.get_root());
+    while(!q.empty()){
+        int id = q.front();
+        q.pop();
+        Block *block = (*block_list)[id];
+        // assumption: the blocks must not have right child
+        if(block->get_top_xy().second==chip_height && current_bst.get_right(id)==-1) block_ids.push_back(id);
+        if(current_bst.get_left(id)!=-1)  q.push(current_bst.get_left(id)); 
+        if(current_bst.get_right(id)!=-1)  q.push(current_bst.get_right(id));
     }
-    _hor.insert(it, new_corners.begin(), new_corners.end());
-    // remove redundant corners
-    vector<XY>::iterator it_prev = _hor.begin();
-    it = it_prev+1;
-    while(it!=_hor.end()){
-        XY xy = *it;
-        XY xy_prev = *it_prev;
-        if(xy.first != xy_prev.first){
-            // if the track forms a vertical line, remove the points at the middle
-            if(it - it_prev > 2){
-                int dif = it-it_prev-2;
-                it_prev++;
-                while(dif--){
-                    it_prev = _hor.erase(it_prev);
+    return block_ids;
+}
+
+void BSTEngine::place_block(int parent, Block *block, bool LR)
+{
+    int x,y;
+    if(parent==-1){
+        x = 0;
+        y = 0;
+        // cout<<"Place base block\n";
+    }
+    else if(LR){
+        x = (*block_list)[parent]->get_low_xy().first;
+        y = contour.find_blk_y(block, x);
+        // cout<<"Place block on the top\n";
+    }
+    else{
+        x = (*block_list)[parent]->get_top_xy().first;
+        y = contour.find_blk_y(block, x);
+        // cout<<"Place block on the right\n";
+    }
+    block->set_x(x);
+    block->set_y(y);
+    // block->print();
+    contour.update(block);
+    // contour.print();
+    // cout<<endl;
+}
+
+void BSTEngine::update_dfs_order()
+{
+    current_bst.get_dfs_order(dfs_order, dfs_stack);
+    dfs_pos.resize(get_num_blocks());
+    for(int pos = 0; pos<dfs_order.size(); pos++){
+        dfs_pos[dfs_order[pos]] = pos;
+    }
+}
+
+// a node is placed at the same position as long as all nodes before it
+// in DFS order keep their blocks, orientations and relative links
+int BSTEngine::find_first_changed()
+{
+    for(int pos = 0; pos<num_cached; pos++){
+        int id = dfs_order[pos];
+        PackRecord &record = pack_cache[pos];
+        int parent = current_bst.get_parent(id);
+        int parent_pos = parent!=-1 ? dfs_pos[parent] : -1;
+        bool LR = current_bst.is_right_child(id);
+        if(record.id!=id || record.orien!=current_bst.get_orien(id) || record.parent!=parent_pos || record.LR!=LR) return pos;
+    }
+    return num_cached;
+}
+
+bool BSTEngine::pack_from(int pos, int &chip_width, int &chip_height, vector<int> &moved_blocks, double max_area)
+{
+    // the extra record keeps the packing state after the last node
+    pack_cache.resize(get_num_blocks()+1);
+    if(pos==0){
+        contour.reset();
+        chip_width = 0;
+        chip_height = 0;
+    }
+    else{
+        // roll back the contour and chip dimension right before the node
+        contour.rollback(pack_cache[pos].contour_mark);
+        chip_width = pack_cache[pos].chip_width;
+        chip_height = pack_cache[pos].chip_height;
+    }
+    for(; pos<get_num_blocks(); pos++){
+        int id = dfs_order[pos];
+        int parent = current_bst.get_parent(id);
+        Block *block = (*block_list)[id];
+        // cache packing state before placing the block
+        PackRecord &record = pack_cache[pos];
+        record.id = id;
+        record.orien = current_bst.get_orien(id);
+        record.parent = parent!=-1 ? dfs_pos[parent] : -1;
+        record.LR = current_bst.is_right_child(id);
+        record.chip_width = chip_width;
+        record.chip_height = chip_height;
+        record.contour_mark = contour.get_mark();
+        // check block orientation
+        CenterXY prev_center = block->get_center_xy();
+        if(block->get_orien()!=record.orien) block->rotate();
+        // set block coordinate
+        place_block(parent, block, record.LR);
+        num_placed++;
+        if(block->get_center_xy()!=prev_center) moved_blocks.push_back(id);
+        // update chip width and height
+        int topx, topy;
+        tie(topx, topy) = block->get_top_xy();
+        chip_width = max(chip_width, topx);
+        chip_height = max(chip_height, topy);
+        // chip width and height only grow with the remaining blocks
+        if((double)chip_width*chip_height > max_area){
+            // the remaining blocks keep their coordinates until they are packed again
+            pack_cache[pos+1].chip_width = chip_width;
+            pack_cache[pos+1].chip_height = chip_height;
+            pack_cache[pos+1].contour_mark = contour.get_mark();
+            num_cached = pos+1;
+            return false;
+        }
+    }
+    pack_cache[get_num_blocks()].chip_width = chip_width;
+    pack_cache[get_num_blocks()].chip_height = chip_height;
+    pack_cache[get_num_blocks()].contour_mark = contour.get_mark();
+    num_cached = get_num_blocks();
+    return true;
+}
+
+void BSTEngine::random_operation(RandomEngine &rand_gen)
+{
+    int op = rand_gen.below(3);
+    int b1_id = rand_gen.below(get_num_blocks());
+    int b2_id = rand_gen.below(get_num_blocks());
+    bool LR = rand_gen.below(2);
+    while(b2_id == b1_id){b2_id = rand_gen.below(get_num_blocks());}
+    // record current tree for undo
+    undo.op = op;
+    if(op==0){
+        // remove b1
+        while(current_bst.get_left(b1_id)!=-1 && current_bst.get_right(b1_id)!=-1 || b1_id==current_bst.get_root()){
+            b1_id = rand_gen.below(get_num_blocks());
+        }
+        undo.parent = current_bst.get_parent(b1_id);
+        undo.LR = current_bst.is_right_child(b1_id);
+        undo.child_LR = current_bst.get_right(b1_id)!=-1;
+        current_bst.remove(b1_id);
+        // append b1 under b2
+        while(b1_id==b2_id || !current_bst.append(b2_id, b1_id, LR)){
+            LR = rand_gen.below(2);
+            b2_id = rand_gen.below(get_num_blocks());
+        }
+    }
+    else if(op==1){
+        // rotate b1
+        current_bst.rotate(b1_id);
+    }
+    else if(op==2){
+        // swap b1 and b2
+        current_bst.swap(b1_id, b2_id);
+    }
+    undo.b1 = b1_id;
+    undo.b2 = b2_id;
+    // cout<<"op="<<op<<", b1="<<(*block_list)[b1_id]->get_name()<<", b2="<<(*block_list)[b2_id]->get_name()<<", LR="<<LR<<endl;
+}
+
+// revert the last random operation without re-packing
+void BSTEngine::undo_operation()
+{
+    if(undo.op==0){
+        current_bst.remove(undo.b1);
+        current_bst.insert(undo.parent, undo.b1, undo.LR, undo.child_LR);
+    }
+    else if(undo.op==1){
+        current_bst.rotate(undo.b1);
+    }
+    else if(undo.op==2){
+        current_bst.swap(undo.b1, undo.b2);
+    }
+}
+
+bool compare_block_by_width(Block* b1, Block *b2)
+{
+    if(b1->get_width() > b2->get_width())   return true;
+    else if(b1->get_width() < b2->get_width())   return false;
+    else{
+        if(b1->get_height() > b2->get_height())   return true;
+        else return false;
+    }
+}
+
+void BSTEngine::initial_floorplan(int outline)
+{
+    outline_width = outline;
+    BlockList unplaced_blocks(block_list->begin(), block_list->end());
+    // all blocks have the same orientation
+    // sort block by dominance relation
+    sort(unplaced_blocks.begin(), unplaced_blocks.end(), compare_block_by_width);
+    Block *block;
+    int node;
+    int rightmost;
+    current_bst.init(get_num_blocks());
+    while(!unplaced_blocks.empty()){
+        BlockList::iterator blkit = unplaced_blocks.begin();
+        // start a new layer
+        block = *blkit;
+        node = block->get_id();
+        current_bst.set_orien(node, block->get_orien());
+        if(current_bst.get_root()==-1){
+            if(place_legal(-1, block, true)){
+                place_block(-1, block);
+                if(!current_bst.append(-1, node)){
+                    cerr<<"Error: cannot append node\n";
+                    exit(1);
                 }
-                // if both end has the same points, remove both
-                if(*it_prev==*(it_prev-1)){
-                    it_prev = _hor.erase(it_prev-1);
-                    it_prev = _hor.erase(it_prev);
+                rightmost = current_bst.get_rightmost();
+                blkit = unplaced_blocks.erase(blkit);
+            }
+            else{
+                block->rotate();
+                place_block(-1, block);
+                if(!current_bst.append(-1, node)){
+                    cerr<<"Error: cannot append node\n";
+                    exit(1);
                 }
-                it = it_prev;
+                rightmost = current_bst.get_rightmost();
+                blkit = unplaced_blocks.erase(blkit);
+            }
+        }
+        else{
+            if(place_legal(rightmost, block, true)){
+                place_block(rightmost, block, true);
+                if(!current_bst.append(rightmost, node, true)){
+                    cerr<<"Error: cannot append node\n";
+                    exit(1);
+                }
+                rightmost = node;
+                blkit = unplaced_blocks.erase(blkit);
             }
             else{
-                it_prev = it;
+                block->rotate();
+                place_block(rightmost, block, true);
+                if(!current_bst.append(rightmost, node, true)){
+                    cerr<<"Error: cannot append node\n";
+                    exit(1);
+                }
+                rightmost = node;
+                blkit = unplaced_blocks.erase(blkit);
             }
         }
-        it++;
-    }
-    // update max height
-    max_height = 0;
-    for(XY c : _hor){
-        max_height = max(max_height, c.second);
-    }
-    // WA: insert missing points
-    it = _hor.begin();
-    while(it != _hor.end()-1){
-        if(it->first!=(it+1)->first && it->second!=(it+1)->second){
-            if(it->second > (it+1)->second){
-                it = _hor.insert(it+1, XY(it->first, (it+1)->second));
+        
+        // place as many blocks as possible horizontally
+        while(blkit!=unplaced_blocks.end()){
+            block = *blkit;
+            block->rotate();
+            int block_y = contour.find_blk_y(block, (*block_list)[node]->get_top_xy().first);
+            if(place_legal(node, block, false) && contour.get_max_height()>=block_y+block->get_height()){
+                current_bst.set_orien(block->get_id(), block->get_orien());
+                place_block(node, block, false);
+                if(!current_bst.append(node, block->get_id(), false)){
+                    cerr<<"Error: cannot append node\n";
+                    exit(1);
+                }
+                node = block->get_id();
+                blkit = unplaced_blocks.erase(blkit);
+                continue;
             }
             else{
-                it = _hor.insert(it+1, XY((it+1)->first, it->second));
+                // rotate back to keep dominance relation if still fail to place
+                block->rotate();
+                if(place_legal(node, block, false)){
+                    current_bst.set_orien(block->get_id(), block->get_orien());
+                    place_block(node, block, false);
+                    if(!current_bst.append(node, block->get_id(), false)){
+                        cerr<<"Error: cannot append node\n";
+                        exit(1);
+                    }
+                    node = block->get_id();
+                    blkit = unplaced_blocks.erase(blkit);
+                    continue;
+                }
             }
+            blkit++;
         }
-        it++;
+        // no more block can fill in the remaining horizontal space
+        // the result would be a like merging several skewed trees
     }
 }
 
-void Contour::check()
+
+// compute with pre-order traversal for a compacted result
+// packing resumes from the first node whose position can change
+bool BSTEngine::pack(int &chip_width, int &chip_height, vector<int> &moved_blocks, double max_area)
 {
-    // check horizontal
-    vector<XY>::iterator it = _hor.begin()+1;
-    while(it!=_hor.end()){
-        XY xy = *it;
-        if(xy.first < (it-1)->first){
-            cerr<<"Error horizontal contour: next corner has larger x value than previous corner\n";
-            print();
-            exit(1);
+    // update DFS order of current B*-tree topology
+    update_dfs_order();
+    if(dfs_order.size() != get_num_blocks()){
+        cerr<<"Block number mismatch with node number\n";
+        cerr<<"num nodes: "<<dfs_order.size()<<endl;
+        cerr<<"num blocks: "<<get_num_blocks()<<endl;
+        exit(1);
+    }
+    // update coordinates for all blocks and maintain contour given current B*-tree topology
+    // update chip width and height
+#ifdef DEBUG
+    if(current_bst.get_hash()!=current_bst.calculate_hash()){
+        cerr<<"Error: incremental B*-tree hash mismatches full computation\n";
+        exit(1);
+    }
+#endif
+    if(!pack_from(find_first_changed(), chip_width, chip_height, moved_blocks, max_area)) return false;
+#ifdef DEBUG
+    contour.check();
+    check_packing(chip_width, chip_height);
+#endif
+    return true;
+}
+
+// incremental packing against packing all blocks from scratch, with the skyline
+// taken as the highest top of the blocks placed before within the range of each block
+void BSTEngine::check_packing(int chip_width, int chip_height) const
+{
+    int width = 0, height = 0;
+    vector<XY> low(get_num_blocks());
+    for(int pos = 0; pos<get_num_blocks(); pos++){
+        int id = dfs_order[pos];
+        int parent = current_bst.get_parent(id);
+        Block *block = (*block_list)[id];
+        int x = 0, y = 0;
+        if(parent!=-1){
+            Block *parent_block = (*block_list)[parent];
+            x = current_bst.is_right_child(id) ? low[parent].first : low[parent].first + parent_block->get_width();
         }
-        if(xy.first != (it-1)->first && xy.second != (it-1)->second){
-            cerr<<"Error horizontal contour: contour not continuous\n";
-            print();
+        for(int prev_pos = 0; prev_pos<pos; prev_pos++){
+            int prev_id = dfs_order[prev_pos];
+            Block *prev_block = (*block_list)[prev_id];
+            if(low[prev_id].first < x + block->get_width() && x < low[prev_id].first + prev_block->get_width())
+                y = max(y, low[prev_id].second + prev_block->get_height());
+        }
+        low[id] = XY(x, y);
+        // a square block keeps its orientation when rotated
+        bool orien_mismatch = block->get_orien()!=current_bst.get_orien(id) && block->get_width()!=block->get_height();
+        if(orien_mismatch || block->get_low_xy()!=low[id]){
+            cerr<<"Error: incremental packing mismatches full packing at block "<<block->get_name()<<endl;
             exit(1);
         }
-        it++;
+        width = max(width, x + block->get_width());
+        height = max(height, y + block->get_height());
+    }
+    if(width!=chip_width || height!=chip_height || height!=contour.get_max_height()){
+        cerr<<"Error: incremental chip dimension mismatches full packing\n";
+        exit(1);
     }
-}
\ No newline at end of file
+}
+
+// the tree of a cluster takes the place of its node in the top tree:
+// the left child of the cluster goes on the right of its rightmost block,
+// which has no left child, and the right child above its left column,
+// so both are packed at the same positions relative to the cluster as in the top tree
+void BSTEngine::merge(const Engine &top, const vector<const Engine*> &clusters, const vector<vector<int>> &cluster_blocks)
+{
+    const BST &top_bst = static_cast<const BSTEngine&>(top).current_bst;
+    int num_clusters = clusters.size();
+    vector<int> roots(num_clusters);
+    vector<int> right_ends(num_clusters);
+    vector<int> column_ends(num_clusters);
+    current_bst.init(get_num_blocks());
+    for(int c = 0; c<num_clusters; c++){
+        const BSTEngine *cluster = static_cast<const BSTEngine*>(clusters[c]);
+        const BST &bst = cluster->current_bst;
+        const vector<int> &ids = cluster_blocks[c];
+        int right_end = 0;
+        for(int id = 0; id<ids.size(); id++){
+            current_bst.set_orien(ids[id], bst.get_orien(id));
+            if(bst.get_left(id)!=-1) current_bst.append(ids[id], ids[bst.get_left(id)], false);
+            if(bst.get_right(id)!=-1) current_bst.append(ids[id], ids[bst.get_right(id)], true);
+            if((*cluster->block_list)[id]->get_top_xy().first > (*cluster->block_list)[right_end]->get_top_xy().first) right_end = id;
+        }
+        roots[c] = ids[bst.get_root()];
+        right_ends[c] = ids[right_end];
+        column_ends[c] = ids[bst.get_rightmost()];
+    }
+    for(int c = 0; c<num_clusters; c++){
+        int parent = top_bst.get_parent(c);
+        if(parent==-1) current_bst.append(-1, roots[c]);
+        else if(top_bst.is_right_child(c)) current_bst.append(column_ends[parent], roots[c], true);
+        else current_bst.append(right_ends[parent], roots[c], false);
+    }
+    num_cached = 0;
+}
+
+Engine* BSTEngine::clone(BlockList *blocks) const
+{
+    BSTEngine *engine = new BSTEngine(*this);
+    engine->block_list = blocks;
+    engine->num_placed = 0;
+    return engine;
+}
+
+void BSTEngine::copy(const Engine &engine, bool best)
+{
+    const BSTEngine &other = static_cast<const BSTEngine&>(engine);
+    current_bst.replace(best ? other.best_bst : other.current_bst);
+}
+
+void BSTEngine::write(ostream &output) const
+{
+    current_bst.write(output);
+    best_bst.write(output);
+}
+
+bool BSTEngine::read(istream &input)
+{
+    // packing starts over for the new tree
+    num_cached = 0;
+    return current_bst.read(input, get_num_blocks()) && best_bst.read(input, get_num_blocks());
+}
+
+void BSTEngine::get_order(vector<int> &order)
+{
+    update_dfs_order();
+    order = dfs_order;
+}
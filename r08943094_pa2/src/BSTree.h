@@ -1,46 +1,91 @@
-#include "module.h"
+#include "engine.h"
 #include <climits>
+#include <cstdint>
+#include <map>
 
 using namespace std;
 
 // B*-tree and node orientation alone will decide the entire floorplan
+// nodes are stored as arrays indexed by block id, -1 stands for no node
 class BST
 {
-    Node *root;
-    double cost;
-    int num_nodes;
+    int root;
+    vector<int> left;
+    vector<int> right;
+    vector<int> parent;
+    vector<char> orien; // orientation, 0 for larger width, 1 for larger height
+    // Zobrist hash: XOR of a key per node for its parent and side, and a key per rotated node
+    // keys are hashed from the node and its link instead of drawn from a table of all pairs of nodes
+    uint64_t hash;
+    static uint64_t mix(uint64_t x){
+        x += 0x9e3779b97f4a7c15ULL;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+    uint64_t link_key(int id) const{return mix((uint64_t)id<<32 | (uint64_t)(parent[id]+1)<<1 | is_right_child(id));}
+    static uint64_t orien_key(int id){return mix((uint64_t)id<<32 | 0xffffffffULL);}
 public:
-    BST() : root(nullptr), cost(INT_MAX) {}
+    BST() : root(-1), hash(0) {}
+    void init(int num_nodes){
+        root = -1;
+        left.assign(num_nodes, -1);
+        right.assign(num_nodes, -1);
+        parent.assign(num_nodes, -1);
+        orien.assign(num_nodes, 0);
+        hash = 0;
+        for(int id = 0; id<num_nodes; id++) hash ^= link_key(id);
+    }
     // getter
-    Node* get_root() const{return root;}
-    Node* get_rightmost() const{
-        Node *n = root;
-        while(n->right){n = n->right;}
+    int get_root() const{return root;}
+    int get_left(int id) const{return left[id];}
+    int get_right(int id) const{return right[id];}
+    int get_parent(int id) const{return parent[id];}
+    bool get_orien(int id) const{return orien[id];}
+    bool is_right_child(int id) const{return parent[id]!=-1 && right[parent[id]]==id;}
+    int get_rightmost() const{
+        int n = root;
+        while(right[n]!=-1){n = right[n];}
         return n;
     }
-    double get_cost() const{return cost;}
-    int get_num_nodes() const{return num_nodes;}
+    int get_num_nodes() const{return left.size();}
+    uint64_t get_hash() const{return hash;}
+    uint64_t calculate_hash() const;
     // setter
-    void set_root(Node *node){root = node;}
-    void set_cost(double val){cost = val;}
+    void set_root(int id){root = id;}
+    void set_orien(int id, bool val){
+        if(orien[id]!=val) hash ^= orien_key(id);
+        orien[id] = val;
+    }
     // method
-    bool remove(Node *node);
-    bool append(Node *parent, Node *node, bool LR=false);
-    void rotate(Node *node);
-    void swap(Node *n1, Node *n2);
-    void replace(BST *tree);
-    void delete_tree(Node *node);
-    void copy(Node *ori_node, Node *new_parent, bool LR=false);
-    void reset_num_nodes(){num_nodes = 0;}
-    void inc_node(){num_nodes++;}
-    void print(Node *node);
+    bool remove(int id);
+    bool append(int parent_id, int id, bool LR=false);
+    void insert(int parent_id, int id, bool LR, bool child_LR);
+    void rotate(int id);
+    void swap(int id1, int id2);
+    void replace(const BST &tree);
+    void get_dfs_order(vector<int> &order, vector<int> &stack) const;
+    void write(ostream &output) const;
+    bool read(istream &input, int num_nodes);
+    void print() const;
 };
 
+// skyline of the packed blocks: each segment starts at a key x and spans
+// to the next key with the mapped height, the last one spans to infinity
+// every modification is journaled so packing can roll back to any earlier block
 class Contour
 {
-    vector<XY> _hor; // horizontal contour
-    vector<XY> _ver; // vertical contour
+    struct Change
+    {
+        int x; // changed segment, -1 for max height
+        int height; // value before the change
+        bool existed; // whether the segment existed before the change
+    };
+    map<int, int> _hor; // horizontal contour
+    vector<Change> journal;
     int max_height;
+    void set_segment(int x, int height);
+    void erase_segment(map<int, int>::iterator it);
 public:
     Contour(){
         reset();
@@ -48,10 +93,13 @@ public:
     int get_max_height() const{return max_height;}
     int find_blk_y(Block *b, int x);
     void update(Block *b);
+    // journal
+    int get_mark() const{return journal.size();}
+    void rollback(int mark);
     void print(){
         cout<<"Horizontal contour:\n";
-        for(XY c : _hor){
-            cout<<"("<<c.first<<","<<c.second<<") ";
+        for(auto seg : _hor){
+            cout<<"("<<seg.first<<","<<seg.second<<") ";
         }
         cout<<endl;
     }
@@ -59,10 +107,77 @@ public:
     void check();
     void reset(){
         _hor.clear();
-        _ver.clear();
-        _hor.push_back(XY(0,0));
-        _hor.push_back(XY(INT_MAX,0));
-        _ver.push_back(XY(0,0));
-        _ver.push_back(XY(0,INT_MAX));
+        journal.clear();
+        _hor[0] = 0;
+        max_height = 0;
     }
-};
\ No newline at end of file
+};
+// packing state of a node along the DFS order, cached to resume packing
+struct PackRecord
+{
+    int id;
+    bool orien;
+    int parent; // DFS position of the parent node, -1 for root
+    bool LR;
+    int chip_width; // chip dimension before placing the node
+    int chip_height;
+    int contour_mark; // contour journal before placing the node
+};
+
+// last random operation on the B*-tree
+struct BSTOperation
+{
+    int op; // 0: move, 1: rotate, 2: swap
+    int b1;
+    int b2;
+    int parent; // original parent of the moved node
+    bool LR; // original side of the moved node under its parent
+    bool child_LR; // side of the child promoted by the removal
+};
+
+// blocks are packed along the pre-order traversal of the B*-tree,
+// a left child on the right of its parent and a right child above it
+class BSTEngine : public Engine
+{
+    BST current_bst;
+    BST best_bst;
+    BSTOperation undo;
+    Contour contour;
+    int outline_width;
+    // incremental packing
+    vector<int> dfs_order;
+    vector<int> dfs_stack;
+    vector<int> dfs_pos; // DFS position of each block
+    vector<PackRecord> pack_cache;
+    int num_cached; // number of valid records in pack_cache
+    // query
+    int get_num_blocks() const{return block_list->size();}
+    bool place_legal(int parent, Block *block, bool LR=false){
+        if(parent==-1) return block->get_width() <= outline_width;
+        else if(LR) return (*block_list)[parent]->get_low_xy().first + block->get_width() <= outline_width;
+        else return (*block_list)[parent]->get_top_xy().first + block->get_width() <= outline_width;
+    }
+    vector<int> get_highest_placed_block_ids(int chip_height) const;
+    // method
+    void place_block(int parent, Block *block, bool LR=false);
+    void update_dfs_order();
+    int find_first_changed();
+    bool pack_from(int pos, int &chip_width, int &chip_height, vector<int> &moved_blocks, double max_area);
+    void check_packing(int chip_width, int chip_height) const;
+public:
+    BSTEngine(BlockList *blocks) : Engine(blocks), outline_width(0), num_cached(0) {}
+    Engine* clone(BlockList *blocks) const;
+    void initial_floorplan(int outline_width);
+    void merge(const Engine &top, const vector<const Engine*> &clusters, const vector<vector<int>> &cluster_blocks);
+    bool pack(int &chip_width, int &chip_height, vector<int> &moved_blocks, double max_area);
+    void random_operation(RandomEngine &rand_gen);
+    void undo_operation();
+    void save_best(){best_bst.replace(current_bst);}
+    void copy(const Engine &engine, bool best);
+    void get_order(vector<int> &order);
+    bool get_orien(int id) const{return current_bst.get_orien(id);}
+    uint64_t get_hash() const{return current_bst.get_hash();}
+    const char* get_name() const{return "bstree";}
+    void write(ostream &output) const;
+    bool read(istream &input);
+};
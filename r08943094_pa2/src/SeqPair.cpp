@@ -0,0 +1,278 @@
+#include "SeqPair.h"
+
+using namespace std;
+
+void SeqPair::init(int num_blocks)
+{
+    pos_seq.resize(num_blocks);
+    neg_seq.resize(num_blocks);
+    for(int i = 0; i<num_blocks; i++){
+        pos_seq[i] = i;
+        neg_seq[i] = i;
+    }
+    pos_index = pos_seq;
+    neg_index = neg_seq;
+    orien.assign(num_blocks, 0);
+}
+
+void SeqPair::set_sequences(const vector<int> &pos, const vector<int> &neg)
+{
+    if(pos.size()!=pos_seq.size() || neg.size()!=neg_seq.size()){
+        cerr<<"Error: sequence length mismatches block number\n";
+        exit(1);
+    }
+    pos_seq = pos;
+    neg_seq = neg;
+    for(int i = 0; i<pos_seq.size(); i++){
+        pos_index[pos_seq[i]] = i;
+        neg_index[neg_seq[i]] = i;
+    }
+}
+
+// exchange two blocks in the positive sequence
+void SeqPair::swap_pos(int id1, int id2)
+{
+    std::swap(pos_seq[pos_index[id1]], pos_seq[pos_index[id2]]);
+    std::swap(pos_index[id1], pos_index[id2]);
+}
+
+// exchange two blocks in both sequences, keeping their relations to other blocks
+void SeqPair::swap_both(int id1, int id2)
+{
+    swap_pos(id1, id2);
+    std::swap(neg_seq[neg_index[id1]], neg_seq[neg_index[id2]]);
+    std::swap(neg_index[id1], neg_index[id2]);
+}
+
+void SeqPair::rotate(int id)
+{
+    orien[id] = !orien[id];
+}
+
+// replace an entire sequence pair by another one
+void SeqPair::replace(const SeqPair &sp)
+{
+    // arrays are copied in place without reallocation
+    *this = sp;
+}
+
+// positive sequence, negative sequence, then orientation of every block
+void SeqPair::write(ostream &output) const
+{
+    for(int id : pos_seq) output<<id<<" ";
+    output<<"\n";
+    for(int id : neg_seq) output<<id<<" ";
+    output<<"\n";
+    for(char o : orien) output<<(int)o<<" ";
+    output<<"\n";
+}
+
+// a sequence pair written by write, false unless both sequences are permutations of the blocks
+bool SeqPair::read(istream &input, int num_blocks)
+{
+    init(num_blocks);
+    vector<int> pos(num_blocks), neg(num_blocks);
+    vector<char> seen_pos(num_blocks, 0), seen_neg(num_blocks, 0);
+    for(int i = 0; i<num_blocks; i++){
+        if(!(input>>pos[i]) || pos[i]<0 || pos[i]>=num_blocks || seen_pos[pos[i]]) return false;
+        seen_pos[pos[i]] = 1;
+    }
+    for(int i = 0; i<num_blocks; i++){
+        if(!(input>>neg[i]) || neg[i]<0 || neg[i]>=num_blocks || seen_neg[neg[i]]) return false;
+        seen_neg[neg[i]] = 1;
+    }
+    for(int id = 0; id<num_blocks; id++){
+        int o;
+        if(!(input>>o)) return false;
+        orien[id] = o!=0;
+    }
+    set_sequences(pos, neg);
+    return true;
+}
+
+void SeqPair::print() const
+{
+    cout<<"Positive sequence:";
+    for(int id : pos_seq) cout<<" #"<<id;
+    cout<<"\nNegative sequence:";
+    for(int id : neg_seq) cout<<" #"<<id;
+    cout<<endl;
+}
+
+// weighted longest common subsequence of the positive sequence, or its reverse,
+// and the negative sequence: the coordinate of a block is the length of the
+// longest subsequence before it, the chip dimension is the overall longest one
+// evaluation stops once the longest subsequence exceeds max_length
+int SPEngine::evaluate_lcs(bool reverse, const vector<int> &weights, vector<int> &coords, double max_length)
+{
+    int n = get_num_blocks();
+    lcs.clear();
+    for(int i = 0; i<n; i++){
+        int id = current_sp.get_pos(reverse ? n-1-i : i);
+        int index = current_sp.get_neg_index(id);
+        // lengths increase with the index, so the closest earlier block has the longest subsequence
+        map<int, int>::iterator it = lcs.lower_bound(index);
+        num_placed++;
+        coords[id] = it==lcs.begin() ? 0 : prev(it)->second;
+        int length = coords[id] + weights[id];
+        it = lcs.emplace_hint(it, index, length);
+        // later blocks with no longer subsequences are dominated
+        for(it++; it!=lcs.end() && it->second<=length;){
+            it = lcs.erase(it);
+        }
+        if(lcs.rbegin()->second > max_length) return lcs.rbegin()->second;
+    }
+    return lcs.empty() ? 0 : lcs.rbegin()->second;
+}
+
+bool SPEngine::pack(int &chip_width, int &chip_height, vector<int> &moved_blocks, double max_area)
+{
+    int n = get_num_blocks();
+    widths.resize(n);
+    heights.resize(n);
+    xs.resize(n);
+    ys.resize(n);
+    int max_height = 0;
+    for(int id = 0; id<n; id++){
+        // block dimension in the orientation of the sequence pair
+        Block *block = (*block_list)[id];
+        bool rotated = block->get_orien()!=current_sp.get_orien(id);
+        widths[id] = rotated ? block->get_height() : block->get_width();
+        heights[id] = rotated ? block->get_width() : block->get_height();
+        max_height = max(max_height, heights[id]);
+    }
+    // chip height is at least the highest block
+    chip_width = evaluate_lcs(false, widths, xs, max_area/max_height);
+    chip_height = max_height;
+    if((double)chip_width*chip_height > max_area) return false;
+    chip_height = evaluate_lcs(true, heights, ys, max_area/chip_width);
+    if((double)chip_width*chip_height > max_area) return false;
+    for(int id = 0; id<n; id++){
+        Block *block = (*block_list)[id];
+        CenterXY prev_center = block->get_center_xy();
+        if(block->get_orien()!=current_sp.get_orien(id)) block->rotate();
+        block->set_x(xs[id]);
+        block->set_y(ys[id]);
+        if(block->get_center_xy()!=prev_center) moved_blocks.push_back(id);
+    }
+    return true;
+}
+
+// blocks lying flat are filled into rows bottom up, higher blocks first
+void SPEngine::initial_floorplan(int outline_width)
+{
+    int n = get_num_blocks();
+    current_sp.init(n);
+    BlockList blocks(block_list->begin(), block_list->end());
+    sort(blocks.begin(), blocks.end(), [](Block *b1, Block *b2){
+        return min(b1->get_width(), b1->get_height()) > min(b2->get_width(), b2->get_height());
+    });
+    vector<vector<int>> rows;
+    int row_width = 0;
+    for(Block *block : blocks){
+        int width = max(block->get_width(), block->get_height());
+        if(rows.empty() || row_width>0 && row_width+width>outline_width){
+            rows.emplace_back();
+            row_width = 0;
+        }
+        rows.back().push_back(block->get_id());
+        row_width += width;
+        current_sp.set_orien(block->get_id(), 0);
+    }
+    // a row is below the next one: it comes after the next row in the positive sequence
+    // but before the next row in the negative sequence
+    vector<int> pos, neg;
+    for(int r = rows.size()-1; r>=0; r--){
+        pos.insert(pos.end(), rows[r].begin(), rows[r].end());
+    }
+    for(int r = 0; r<rows.size(); r++){
+        neg.insert(neg.end(), rows[r].begin(), rows[r].end());
+    }
+    current_sp.set_sequences(pos, neg);
+}
+
+// the sequences of a cluster take the place of the cluster in the top sequences,
+// keeping the relations between blocks of different clusters
+void SPEngine::merge(const Engine &top, const vector<const Engine*> &clusters, const vector<vector<int>> &cluster_blocks)
+{
+    const SeqPair &top_sp = static_cast<const SPEngine&>(top).current_sp;
+    current_sp.init(get_num_blocks());
+    vector<int> pos, neg;
+    for(int i = 0; i<top_sp.get_num_blocks(); i++){
+        int c = top_sp.get_pos(i);
+        const SeqPair &sp = static_cast<const SPEngine*>(clusters[c])->current_sp;
+        for(int j = 0; j<sp.get_num_blocks(); j++){
+            pos.push_back(cluster_blocks[c][sp.get_pos(j)]);
+        }
+    }
+    for(int i = 0; i<top_sp.get_num_blocks(); i++){
+        int c = top_sp.get_neg(i);
+        const SeqPair &sp = static_cast<const SPEngine*>(clusters[c])->current_sp;
+        for(int j = 0; j<sp.get_num_blocks(); j++){
+            neg.push_back(cluster_blocks[c][sp.get_neg(j)]);
+        }
+    }
+    for(int c = 0; c<clusters.size(); c++){
+        const SeqPair &sp = static_cast<const SPEngine*>(clusters[c])->current_sp;
+        for(int id = 0; id<sp.get_num_blocks(); id++){
+            current_sp.set_orien(cluster_blocks[c][id], sp.get_orien(id));
+        }
+    }
+    current_sp.set_sequences(pos, neg);
+}
+
+void SPEngine::random_operation(RandomEngine &rand_gen)
+{
+    int op = rand_gen.below(3);
+    int b1_id = rand_gen.below(get_num_blocks());
+    int b2_id = rand_gen.below(get_num_blocks());
+    while(b2_id == b1_id){b2_id = rand_gen.below(get_num_blocks());}
+    undo = SPOperation{op, b1_id, b2_id};
+    apply_operation(undo);
+}
+
+void SPEngine::apply_operation(const SPOperation &operation)
+{
+    if(operation.op==0){
+        current_sp.swap_pos(operation.b1, operation.b2);
+    }
+    else if(operation.op==1){
+        current_sp.rotate(operation.b1);
+    }
+    else if(operation.op==2){
+        current_sp.swap_both(operation.b1, operation.b2);
+    }
+}
+
+Engine* SPEngine::clone(BlockList *blocks) const
+{
+    SPEngine *engine = new SPEngine(*this);
+    engine->block_list = blocks;
+    engine->num_placed = 0;
+    return engine;
+}
+
+void SPEngine::copy(const Engine &engine, bool best)
+{
+    const SPEngine &other = static_cast<const SPEngine&>(engine);
+    current_sp.replace(best ? other.best_sp : other.current_sp);
+}
+
+void SPEngine::get_order(vector<int> &order)
+{
+    order.clear();
+    for(int i = 0; i<current_sp.get_num_blocks(); i++){
+        order.push_back(current_sp.get_pos(i));
+    }
+}
+
+void SPEngine::write(ostream &output) const
+{
+    current_sp.write(output);
+    best_sp.write(output);
+}
+
+bool SPEngine::read(istream &input)
+{
+    return current_sp.read(input, get_num_blocks()) && best_sp.read(input, get_num_blocks());
+}
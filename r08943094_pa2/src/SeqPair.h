@@ -0,0 +1,79 @@
+#include "engine.h"
+#include <map>
+
+using namespace std;
+
+// sequence pair and block orientation alone will decide the entire floorplan
+// block a is on the left of block b if a precedes b in both sequences,
+// and a is below b if a follows b in the positive sequence but precedes b in the negative one
+class SeqPair
+{
+    vector<int> pos_seq; // positive sequence of block ids
+    vector<int> neg_seq; // negative sequence of block ids
+    vector<int> pos_index; // index of each block in the positive sequence
+    vector<int> neg_index; // index of each block in the negative sequence
+    vector<char> orien; // orientation, 0 for larger width, 1 for larger height
+public:
+    void init(int num_blocks);
+    // getter
+    int get_num_blocks() const{return pos_seq.size();}
+    int get_pos(int i) const{return pos_seq[i];}
+    int get_neg(int i) const{return neg_seq[i];}
+    int get_pos_index(int id) const{return pos_index[id];}
+    int get_neg_index(int id) const{return neg_index[id];}
+    bool get_orien(int id) const{return orien[id];}
+    // setter
+    void set_sequences(const vector<int> &pos, const vector<int> &neg);
+    void set_orien(int id, bool val){orien[id] = val;}
+    // method
+    void swap_pos(int id1, int id2);
+    void swap_both(int id1, int id2);
+    void rotate(int id);
+    void replace(const SeqPair &sp);
+    void write(ostream &output) const;
+    bool read(istream &input, int num_blocks);
+    void print() const;
+};
+
+// last random operation on the sequence pair, every operation is its own inverse
+struct SPOperation
+{
+    int op; // 0: swap in the positive sequence, 1: rotate, 2: swap in both sequences
+    int b1;
+    int b2;
+};
+
+// block coordinates are weighted longest common subsequences of the two sequences,
+// computed in O(n log n) with an ordered map pruned to increasing lengths
+class SPEngine : public Engine
+{
+    SeqPair current_sp;
+    SeqPair best_sp;
+    SPOperation undo;
+    // packing buffers indexed by block id
+    vector<int> widths;
+    vector<int> heights;
+    vector<int> xs;
+    vector<int> ys;
+    map<int, int> lcs; // negative sequence index -> longest subsequence ending at the block
+    // query
+    int get_num_blocks() const{return block_list->size();}
+    // method
+    int evaluate_lcs(bool reverse, const vector<int> &weights, vector<int> &coords, double max_length);
+    void apply_operation(const SPOperation &operation);
+public:
+    SPEngine(BlockList *blocks) : Engine(blocks) {}
+    Engine* clone(BlockList *blocks) const;
+    void initial_floorplan(int outline_width);
+    void merge(const Engine &top, const vector<const Engine*> &clusters, const vector<vector<int>> &cluster_blocks);
+    bool pack(int &chip_width, int &chip_height, vector<int> &moved_blocks, double max_area);
+    void random_operation(RandomEngine &rand_gen);
+    void undo_operation(){apply_operation(undo);}
+    void save_best(){best_sp.replace(current_sp);}
+    void copy(const Engine &engine, bool best);
+    void get_order(vector<int> &order);
+    bool get_orien(int id) const{return current_sp.get_orien(id);}
+    const char* get_name() const{return "seqpair";}
+    void write(ostream &output) const;
+    bool read(istream &input);
+};
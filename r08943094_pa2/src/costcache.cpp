@@ -0,0 +1,72 @@
+#include "costcache.h"
+
+using namespace std;
+
+void CostCache::reset(int size)
+{
+    capacity = size;
+    nodes.clear();
+    index.clear();
+    head = tail = -1;
+    num_lookups = 0;
+    num_hits = 0;
+}
+
+void CostCache::unlink(int i)
+{
+    Node &node = nodes[i];
+    if(node.prev!=-1) nodes[node.prev].next = node.next;
+    else head = node.next;
+    if(node.next!=-1) nodes[node.next].prev = node.prev;
+    else tail = node.prev;
+}
+
+void CostCache::push_front(int i)
+{
+    nodes[i].prev = -1;
+    nodes[i].next = head;
+    if(head!=-1) nodes[head].prev = i;
+    head = i;
+    if(tail==-1) tail = i;
+}
+
+bool CostCache::lookup(uint64_t key, CostEntry &entry)
+{
+    num_lookups++;
+    unordered_map<uint64_t, int>::iterator it = index.find(key);
+    if(it==index.end()) return false;
+    num_hits++;
+    int i = it->second;
+    if(i!=head){
+        unlink(i);
+        push_front(i);
+    }
+    entry = nodes[i].entry;
+    return true;
+}
+
+void CostCache::insert(uint64_t key, const CostEntry &entry)
+{
+    if(capacity<=0) return;
+    unordered_map<uint64_t, int>::iterator it = index.find(key);
+    if(it!=index.end()){
+        nodes[it->second].entry = entry;
+        return;
+    }
+    int i;
+    if((int)nodes.size() < capacity){
+        i = nodes.size();
+        nodes.push_back(Node());
+        if(index.empty()) index.reserve(capacity);
+    }
+    else{
+        // reuse the least recently used node
+        i = tail;
+        unlink(i);
+        index.erase(nodes[i].key);
+    }
+    nodes[i].key = key;
+    nodes[i].entry = entry;
+    push_front(i);
+    index[key] = i;
+}
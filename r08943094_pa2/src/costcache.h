@@ -0,0 +1,55 @@
+#ifndef COSTCACHE_H
+#define COSTCACHE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// evaluation of a packed representation
+struct CostEntry
+{
+    int chip_width;
+    int chip_height;
+    double WL;
+};
+
+// bounded cache of evaluations keyed by representation hashes, evicting the least recently used
+// entries are linked by index so the cache stays valid when copied with its floorplanner
+class CostCache
+{
+    struct Node
+    {
+        uint64_t key;
+        CostEntry entry;
+        int prev; // more recently used, -1 for head
+        int next; // less recently used, -1 for tail
+    };
+    vector<Node> nodes;
+    unordered_map<uint64_t, int> index;
+    int capacity;
+    int head;
+    int tail;
+    long long num_lookups;
+    long long num_hits;
+    void unlink(int i);
+    void push_front(int i);
+public:
+    CostCache(int size) : capacity(size), head(-1), tail(-1), num_lookups(0), num_hits(0) {}
+    // empty cache of size entries with no statistics
+    void reset(int size);
+    int get_capacity() const{return capacity;}
+    bool is_enabled() const{return capacity > 0;}
+    bool lookup(uint64_t key, CostEntry &entry);
+    void insert(uint64_t key, const CostEntry &entry);
+    void merge_stats(const CostCache &cache){
+        num_lookups += cache.num_lookups;
+        num_hits += cache.num_hits;
+    }
+    long long get_num_lookups() const{return num_lookups;}
+    long long get_num_hits() const{return num_hits;}
+    double get_hit_rate() const{return num_lookups ? (double)num_hits / num_lookups : 0.;}
+};
+
+#endif
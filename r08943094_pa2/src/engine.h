@@ -0,0 +1,54 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "module.h"
+#include "rng.h"
+#include <cstdint>
+
+using namespace std;
+
+typedef vector<Block*> BlockList;
+
+// floorplan representation explored by SA
+// an engine perturbs its representation and packs the blocks accordingly,
+// cost evaluation and the search itself are left to the floorplanner
+class Engine
+{
+protected:
+    BlockList *block_list;
+    long long num_placed; // blocks processed by packing: contour updates of the B*-tree, LCS steps of the sequence pair
+public:
+    Engine(BlockList *blocks) : block_list(blocks), num_placed(0) {}
+    virtual ~Engine() {}
+    // copy of the engine packing another list of the same blocks
+    virtual Engine* clone(BlockList *blocks) const = 0;
+    // initial representation, trying to fit in the outline width
+    virtual void initial_floorplan(int outline_width) = 0;
+    // representation assembled from a floorplan of clusters: block c of the top engine is cluster c,
+    // cluster_blocks[c] maps blocks of the cluster engine to blocks of this engine
+    virtual void merge(const Engine &top, const vector<const Engine*> &clusters, const vector<vector<int>> &cluster_blocks) = 0;
+    // set block coordinates and chip dimension, collecting blocks whose center moved
+    // stop early once the chip area exceeds max_area and return false
+    virtual bool pack(int &chip_width, int &chip_height, vector<int> &moved_blocks, double max_area) = 0;
+    // perturb the current representation, undo reverts the last perturbation
+    virtual void random_operation(RandomEngine &rand_gen) = 0;
+    virtual void undo_operation() = 0;
+    // keep the current representation as the best one
+    virtual void save_best() = 0;
+    // copy the current or best representation of an engine of the same kind
+    virtual void copy(const Engine &engine, bool best) = 0;
+    // blocks in packing order
+    virtual void get_order(vector<int> &order) = 0;
+    // orientation of block id in the current representation, 0 for larger width, 1 for larger height
+    virtual bool get_orien(int id) const = 0;
+    // name of the representation as given to Floorplanner::set_engine
+    virtual const char* get_name() const = 0;
+    // current and best representation as text for checkpoints, read returns false on malformed input
+    virtual void write(ostream &output) const = 0;
+    virtual bool read(istream &input) = 0;
+    // hash of the current representation keying the cost cache, 0 if not hashed
+    virtual uint64_t get_hash() const{return 0;}
+    long long get_num_placed() const{return num_placed;}
+};
+
+#endif
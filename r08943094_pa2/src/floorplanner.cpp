@@ -1,200 +1,243 @@
 #include "floorplanner.h"
 
-#define RAND unif(rand_gen)
+#define RAND rand_gen.uniform()
 #define RGB(r,g,b) (65536 * int(r) + 256 * int(g) + int(b))
 
 using namespace std;
 
-vector<int> Floorplanner::get_highest_placed_block_ids() const
-{
-    // traverse the b*-tree with BFS
-    vector<int> block_ids;
-    queue<Node*> q;
-    q.push(current_bst->get_root());
-    Node *node;
-    while(!q.empty()){
-        node = q.front();
-        q.pop();
-        int id = node->id;
-        Block *block = block_list[id];
-        // assumption: the blocks must not have right child
-        if(block->get_top_xy().second==get_chip_height() && !node->right) block_ids.push_back(id);
-        if(node->left)  q.push(node->left); 
-        if(node->right)  q.push(node->right);
+// pack the current representation and evaluate its cost
+// packing stops early once the cost is sure to exceed the threshold
+bool Floorplanner::update_all_blocks(bool sampling_mode, double threshold)
+{
+    // update coordinates for all blocks and chip width and height
+    Profiler::TimePoint start = profiler.start();
+    bool packed = engine->pack(chip_width, chip_height, moved_blocks, get_max_area(threshold));
+    profiler.stop(PHASE_PACK, start);
+    complete = packed;
+    if(!packed){
+        cost = get_cost_lower_bound();
+        return false;
     }
-    return block_ids;
+    // update wirelength of nets on moved blocks
+    start = profiler.start();
+    update_wl();
+    profiler.stop(PHASE_WIRELENGTH, start);
+    // sample the result and update normalized cost
+    if(sampling_mode) update_normalized_cost();
+    cost = get_normalized_cost();
+    return true;
 }
 
-void Floorplanner::place_block(Node *parent, Block *block, bool LR)
+// evaluate the current representation after a random operation,
+// reusing the evaluation of the same representation if it was packed recently
+void Floorplanner::evaluate(double threshold)
 {
-    int x,y;
-    if(parent==nullptr){
-        x = 0;
-        y = 0;
-        // cout<<"Place base block\n";
-    }
-    else if(LR){
-        x = block_list[parent->id]->get_low_xy().first;
-        y = contour.find_blk_y(block, x);
-        // cout<<"Place block on the top\n";
+    uint64_t key = cost_cache.is_enabled() ? engine->get_hash() : 0;
+    CostEntry entry;
+    if(key && cost_cache.lookup(key, entry)){
+        chip_width = entry.chip_width;
+        chip_height = entry.chip_height;
+        WL = entry.WL;
+        cost = get_normalized_cost();
+        complete = true;
+        return;
     }
-    else{
-        x = block_list[parent->id]->get_top_xy().first;
-        y = contour.find_blk_y(block, x);
-        // cout<<"Place block on the right\n";
-    }
-    block->set_x(x);
-    block->set_y(y);
-    // block->print();
-    contour.update(block);
-    // contour.print();
-    // cout<<endl;
+    // packing stopped early gives no complete evaluation to keep
+    if(update_all_blocks(false, threshold) && key) cost_cache.insert(key, CostEntry{chip_width, chip_height, WL});
 }
 
-// compute with in-order traversal for a compacted result
-void Floorplanner::update_all_blocks(bool sampling_mode)
+// largest chip area whose cost lower bound stays within the threshold
+double Floorplanner::get_max_area(double threshold) const
 {
-    contour.reset();
-    current_bst->reset_num_nodes();
-    chip_width = 0;
-    chip_height = 0;
-    // update coordinates for all blocks and maintain contour given current B*-tree topology
-    // update chip width and height
-    update_block_dfs(current_bst->get_root());
-    contour.check();
-    // update wirelength
-    calculate_wl();
-    // sample the result and update normalized cost
-    if(sampling_mode) update_normalized_cost();
-    // annotate normalized cost on B*-tree
-    current_bst->set_cost(get_normalized_cost());
-    if(current_bst->get_num_nodes() != num_blocks){
-        cerr<<"Block number mismatch with node number\n";
-        cerr<<"num nodes: "<<current_bst->get_num_nodes()<<endl;
-        cerr<<"num blocks: "<<num_blocks<<endl;
-        exit(1);
+    if(threshold==HUGE_VAL || alpha==0.) return HUGE_VAL;
+    return (threshold - (1.-alpha)*terminal_wl/norm_wl) * norm_area / alpha;
+}
+
+// full wirelength computation over all pins
+double Floorplanner::calculate_wl() const
+{
+    double wl = 0.;
+    for(int n = 0; n<num_nets; n++){
+        BBox bbox;
+        for(int k = net_start[n]; k<net_start[n+1]; k++){
+            bbox.add(pin_x[net_pins[k]], pin_y[net_pins[k]]);
+        }
+        wl += bbox.hpwl();
     }
+    return wl;
 }
 
-void Floorplanner::update_block_dfs(Node *node)
+// only nets connected to moved blocks are updated once cached
+void Floorplanner::update_wl()
 {
-    if(!node) return;
-    current_bst->inc_node();
-    Block *block = block_list[node->id];
-    // check block orientation
-    if(block->get_orien()!=node->orien) block->rotate();
-    // set block coordinate
-    if(node==current_bst->get_root()){
-        place_block(nullptr, block);
+    if(!wl_cached){
+        for(int id = 0; id<num_blocks; id++){
+            update_pin(id);
+        }
+        net_bbox.resize(num_nets);
+        net_stamp.assign(num_nets, 0);
+        wl_stamp = 0;
+        packed_wl = 0.;
+        terminal_wl = 0.;
+        for(int n = 0; n<num_nets; n++){
+            update_net_bbox(n);
+            packed_wl += net_bbox[n].hpwl();
+            if(terminal_bbox[n].x1 <= terminal_bbox[n].x2) terminal_wl += terminal_bbox[n].hpwl();
+        }
+        wl_cached = true;
     }
     else{
-        // find parent and check LR
-        Node *parent = node->parent;
-        bool LR = (parent->right==node);
-        place_block(parent, block, LR);
-    }
-    // update chip width and height
-    int topx, topy;
-    tie(topx, topy) = block->get_top_xy();
-    chip_width = max(chip_width, topx);
-    chip_height = max(chip_height, topy);
-    if(node->left==node || node->right==node){
-        cerr<<"Error: Node points to itself\n";
+        for(int id : moved_blocks){
+            update_pin(id);
+        }
+        wl_stamp++;
+        for(int id : moved_blocks){
+            for(int k = block_net_start[id]; k<block_net_start[id+1]; k++){
+                int n = block_nets[k];
+                if(net_stamp[n]==wl_stamp) continue;
+                net_stamp[n] = wl_stamp;
+                packed_wl -= net_bbox[n].hpwl();
+                update_net_bbox(n);
+                packed_wl += net_bbox[n].hpwl();
+            }
+        }
+    }
+    // blocks moved by aborted packings are kept until their nets are updated
+    moved_blocks.clear();
+    WL = packed_wl;
+#ifdef DEBUG
+    for(int id = 0; id<num_blocks; id++){
+        if(CenterXY(pin_x[id], pin_y[id]) != block_list[id]->get_center_xy()){
+            cerr<<"Error: pin of block "<<block_list[id]->get_name()<<" mismatches its center"<<endl;
+            exit(1);
+        }
+    }
+    if(abs(WL - calculate_wl()) > 1e-6){
+        cerr<<"Error: incremental wirelength "<<WL<<" mismatches full computation "<<calculate_wl()<<endl;
         exit(1);
     }
-    update_block_dfs(node->left);
-    update_block_dfs(node->right);
+#endif
 }
 
-void Floorplanner::calculate_wl()
+void Floorplanner::update_net_bbox(int net_id)
 {
-    WL = 0.;
-    for(Net *net : net_list){
-        double x1 = INT_MAX;
-        double x2 = 0;
-        double y1 = INT_MAX;
-        double y2 = 0;
-        for(Terminal *term : net->get_terminals()){
-            double termx, termy;
-            tie(termx, termy) = term->get_center_xy();
-            x1 = min(x1, termx);
-            x2 = max(x2, termx);
-            y1 = min(y1, termy);
-            y2 = max(y2, termy);
-        }
-        double wl = x2-x1 + y2-y1;
-        WL += wl;
+    BBox bbox = terminal_bbox[net_id];
+    for(int k = net_start[net_id]; k<net_block_end[net_id]; k++){
+        bbox.add(pin_x[net_pins[k]], pin_y[net_pins[k]]);
     }
+    net_bbox[net_id] = bbox;
 }
 
 void Floorplanner::backup_floorplan(bool force)
 {
-    if(force || is_legal() && current_bst->get_cost() < best_bst->get_cost()){
-        best_bst->replace(current_bst);
-        print_summary(0);
+    // floorplanners of clusters keep illegal floorplans until a legal one is found
+    if(force || (is_legal() || keep_illegal && !best_legal) && cost < best_cost){
+        Profiler::TimePoint start = profiler.start();
+        engine->save_best();
+        profiler.stop(PHASE_COPY, start);
+        best_cost = cost;
+        best_legal = is_legal();
+        if(profiler.is_enabled()) best_trajectory.emplace_back(get_wall_time(), cost, best_legal);
+        if(verbose && get_wall_time() - last_print_time >= 1.){
+            print_summary(0);
+            last_print_time = get_wall_time();
+        }
     }
 }
 
-void Floorplanner::restore_floorplan(BST *tree)
+// continue from the best floorplan of a floorplanner with the same engine
+void Floorplanner::restore_floorplan(const Floorplanner &source)
 {
-    current_bst->replace(tree);
-    // restore link of node on blocks
-    restore_block_node(current_bst->get_root());
+    Profiler::TimePoint start = profiler.start();
+    engine->copy(*source.engine, true);
+    profiler.stop(PHASE_COPY, start);
     update_all_blocks();
 }
 
-void Floorplanner::restore_block_node(Node *node)
+void Floorplanner::random_operation()
 {
-    if(!node) return;
-    block_list[node->id]->set_node(node);
-    restore_block_node(node->left);
-    restore_block_node(node->right);
+    // record current floorplan for undo
+    undo.chip_width = chip_width;
+    undo.chip_height = chip_height;
+    undo.WL = WL;
+    undo.cost = cost;
+    Profiler::TimePoint start = profiler.start();
+    engine->random_operation(rand_gen);
+    profiler.stop(PHASE_OPERATION, start);
 }
 
-void Floorplanner::random_operation()
+// revert the last random operation without re-packing
+// block coordinates are refreshed by the next packing
+void Floorplanner::undo_operation()
 {
-    int op = RAND*3;
-    int b1_id = RAND*num_blocks;
-    int b2_id = RAND*num_blocks;
-    bool LR = RAND > 0.5;
-    while(b2_id == b1_id){b2_id = RAND*num_blocks;}
-    if(op==0){
-        // remove b1
-        Node *n1 = block_list[b1_id]->get_node();
-        while(!current_bst->remove(n1)){
-            b1_id = RAND*num_blocks;
-            n1 = block_list[b1_id]->get_node();
-        }
-        // append b1 under b2
-        Node *n2 = block_list[b2_id]->get_node();
-        while(b1_id==b2_id || !current_bst->append(n2, n1, LR)){
-            LR = RAND > 0.5;
-            b2_id = RAND*num_blocks;
-            n2 = block_list[b2_id]->get_node();
-        }
-    }
-    else if(op==1){
-        // rotate b1
-        Node *n1 = block_list[b1_id]->get_node();
-        current_bst->rotate(n1);
-    }
-    else if(op==2){
-        // swap b1 and b2
-        Node *n1 = block_list[b1_id]->get_node();
-        Node *n2 = block_list[b2_id]->get_node();
-        current_bst->swap(n1, n2);
-    }
-    // cout<<"op="<<op<<", b1="<<block_list[b1_id]->get_name()<<", b2="<<block_list[b2_id]->get_name()<<", LR="<<LR<<endl;
+    engine->undo_operation();
+    chip_width = undo.chip_width;
+    chip_height = undo.chip_height;
+    WL = undo.WL;
+    cost = undo.cost;
+}
+
+// the initial floorplan is a sample of the cost normalization unless it is sampled already
+void Floorplanner::initial_floorplan(bool sampling_mode)
+{
+    // blocks are placed without tracking wirelength
+    wl_cached = false;
+    engine->initial_floorplan(outline_width);
+    update_all_blocks(sampling_mode);
 }
 
 void Floorplanner::sample_normalized_cost()
 {
+    if(num_sample_threads > 1){
+        sample_normalized_cost_parallel();
+        return;
+    }
     for(int i = 0; i<num_blocks*10; i++){
         random_operation();
         update_all_blocks(true);
     }
 }
 
+// the random walk drifts away from the initial floorplan, so replica i samples the i-th
+// share of a walk of its own: operations before its share only perturb the representation,
+// which is cheap without packing, and the averages are merged weighted by sample counts
+void Floorplanner::sample_normalized_cost_parallel()
+{
+    int num_total = num_blocks*10;
+    vector<Floorplanner*> replicas;
+    for(int i = 0; i<num_sample_threads; i++){
+        Floorplanner *replica = create_replica(i+1);
+        replica->num_samples = 0;
+        replica->norm_area = 0.;
+        replica->norm_wl = 0.;
+        replicas.push_back(replica);
+    }
+    ThreadPool pool(num_sample_threads);
+    pool.run(num_sample_threads, [&](int i){
+        Floorplanner *replica = replicas[i];
+        int first = (long long)num_total*i/num_sample_threads;
+        int last = (long long)num_total*(i+1)/num_sample_threads;
+        for(int j = 0; j<first; j++){
+            replica->engine->random_operation(replica->rand_gen);
+        }
+        for(int j = first; j<last; j++){
+            replica->random_operation();
+            replica->update_all_blocks(true);
+        }
+    });
+    double total_area = norm_area * num_samples;
+    double total_wl = norm_wl * num_samples;
+    for(Floorplanner *replica : replicas){
+        total_area += replica->norm_area * replica->num_samples;
+        total_wl += replica->norm_wl * replica->num_samples;
+        num_samples += replica->num_samples;
+        merge_stats(*replica);
+        delete replica;
+    }
+    norm_area = total_area / num_samples;
+    norm_wl = total_wl / num_samples;
+}
+
 void Floorplanner::update_normalized_cost()
 {
     norm_area *= num_samples;
@@ -207,163 +250,641 @@ void Floorplanner::update_normalized_cost()
     // cout<<"sample #"<<num_samples<<", norm area = "<<norm_area<<", norm wl = "<<norm_wl<<endl;
 }
 
-bool compare_block_by_width(Block* b1, Block *b2)
+// given an initial solution
+// Fast-SA: a random walk at the initial temperature, then pseudo-greedy local search
+// for a few temperatures, and hill climbing with temperatures following the average
+// cost change, until the best legal cost stops improving
+void Floorplanner::SA()
 {
-    if(b1->get_width() > b2->get_width())   return true;
-    else if(b1->get_width() < b2->get_width())   return false;
-    else{
-        if(b1->get_height() > b2->get_height())   return true;
-        else return false;
-    }
-}
-
-void Floorplanner::initial_floorplan(BlockList &unplaced_blocks)
-{
-    // all blocks have the same orientation
-    // sort block by dominance relation
-    sort(unplaced_blocks.begin(), unplaced_blocks.end(), compare_block_by_width);
-    Block *block;
-    Node *node;
-    Node *rightmost;
-    while(!unplaced_blocks.empty()){
-        BlockList::iterator blkit = unplaced_blocks.begin();
-        // start a new layer
-        block = *blkit;
-        node = new Node(block);
-        if(current_bst->get_root()==nullptr){
-            if(place_legal(nullptr, block, true)){
-                place_block(nullptr, block);
-                if(!current_bst->append(nullptr, block->get_node())){
-                    cerr<<"Error: cannot append node\n";
-                    exit(1);
-                }
-                rightmost = current_bst->get_rightmost();
-                blkit = unplaced_blocks.erase(blkit);
-            }
-            else{
-                block->rotate();
-                place_block(nullptr, block);
-                if(!current_bst->append(nullptr, block->get_node())){
-                    cerr<<"Error: cannot append node\n";
-                    exit(1);
-                }
-                rightmost = current_bst->get_rightmost();
-                blkit = unplaced_blocks.erase(blkit);
-            }
+    if(verbose) cout<<"Start SA optimization\n";
+    int num_iter = resumed ? resume_state.num_iter : 1;
+    int num_operation = fast_schedule ? num_blocks*20 : num_blocks*200;
+    int max_iter = 4603; // number of temperatures of geometric cooling
+    double T1 = resumed ? resume_state.T1 : fast_schedule ? initial_temperature() : 1.;
+    double T = resumed ? resume_state.T : T1;
+    double Tmin = 0.01;
+    double r = 0.999;
+    double c = 100.; // Fast-SA stage 2 scale
+    int k = 7; // Fast-SA last stage 2 temperature
+    int num_plateau = resumed ? resume_state.num_plateau : 0;
+    // workers evaluating speculative operations
+    vector<Floorplanner*> workers;
+    for(int i = 0; num_speculations>1 && i<num_speculations; i++){
+        workers.push_back(create_replica(i+1));
+    }
+    ThreadPool pool(workers.size());
+    while(num_iter <= max_iter && (fast_schedule || T > Tmin)){
+        // cout<<"Iter #"<<num_iter<<endl;
+        double prev_best_cost = best_cost;
+        double start_time = get_wall_time();
+        restore_floorplan(*this);
+        stats = AnnealStats();
+#ifdef DEBUG
+        // one speculative worker drawing the same random numbers has to follow anneal()
+        Floorplanner *shadow = workers.empty() ? create_replica(0) : nullptr;
+        vector<Floorplanner*> shadow_workers;
+        if(shadow){
+            shadow_workers.push_back(create_replica(0));
+            shadow_workers[0]->rand_gen = rand_gen;
+            shadow_workers[0]->cost_cache = cost_cache;
+        }
+#endif
+        if(workers.empty()) anneal(T, num_operation);
+        else anneal_speculative(T, num_operation, workers, pool);
+#ifdef DEBUG
+        if(shadow){
+            check_speculative(*shadow, shadow_workers, T, num_operation);
+            delete shadow_workers[0];
+            delete shadow;
+        }
+#endif
+        trace_temperature("sa", num_iter, T, stats, get_wall_time() - start_time);
+        num_iter++;
+        // stop if the best legal floorplan stops improving or time is up
+        if(best_cost < prev_best_cost) num_plateau = 0;
+        else num_plateau++;
+        if((best_legal || keep_illegal) && num_plateau >= plateau_window){
+            if(verbose) cout<<"Best cost has not improved for "<<num_plateau<<" temperatures\n";
+            break;
+        }
+        if(time_up()){
+            if(verbose) cout<<"Time limit reached\n";
+            break;
         }
+        // reduce temperature
+        if(!fast_schedule) T *= r;
         else{
-            if(place_legal(rightmost, block, true)){
-                place_block(rightmost, block, true);
-                if(!current_bst->append(rightmost, block->get_node(), true)){
-                    cerr<<"Error: cannot append node\n";
-                    exit(1);
-                }
-                rightmost = node;
-                blkit = unplaced_blocks.erase(blkit);
-            }
-            else{
-                block->rotate();
-                place_block(rightmost, block, true);
-                if(!current_bst->append(rightmost, block->get_node(), true)){
-                    cerr<<"Error: cannot append node\n";
-                    exit(1);
+            double avg_delta = stats.total_delta / max(stats.num_evaluated, 1);
+            if(num_iter <= k) T = T1 * avg_delta / (num_iter * c);
+            else T = T1 * avg_delta / num_iter;
+        }
+        write_checkpoint(SAState{num_iter, T1, T, num_plateau});
+    }
+    for(Floorplanner *worker : workers){
+        merge_stats(*worker);
+        delete worker;
+    }
+}
+
+// both representations, normalization, best cost, random engine and SA state in text,
+// written to a temporary file first so a run stopped while writing keeps the previous checkpoint
+void Floorplanner::write_checkpoint(const SAState &state)
+{
+    if(checkpoint_name.empty() || get_wall_time() - last_checkpoint_time < checkpoint_interval) return;
+    string tmp_name = checkpoint_name + ".tmp";
+    fstream output(tmp_name, ios::out);
+    // doubles are written with enough digits to be read back exactly
+    output<<setprecision(17);
+    output<<"floorplan_checkpoint "<<engine->get_name()<<" "<<num_blocks<<" "<<num_nets<<" "<<alpha<<"\n";
+    output<<norm_area<<" "<<norm_wl<<" "<<num_samples<<"\n";
+    output<<best_cost<<" "<<best_legal<<"\n";
+    output<<state.num_iter<<" "<<state.T1<<" "<<state.T<<" "<<state.num_plateau<<"\n";
+    output<<get_wall_time()<<"\n";
+    output<<rand_gen<<"\n";
+    engine->write(output);
+    output.close();
+    // a failed checkpoint is not worth stopping the run
+    if(!output || rename(tmp_name.c_str(), checkpoint_name.c_str())!=0){
+        cerr<<"Warning: cannot write the checkpoint file \""<<checkpoint_name<<"\"\n";
+    }
+    last_checkpoint_time = get_wall_time();
+}
+
+void Floorplanner::resume(fstream &checkpoint_file)
+{
+    string tag, engine_name;
+    int blocks, nets;
+    double val;
+    if(!(checkpoint_file>>tag>>engine_name>>blocks>>nets>>val) || tag!="floorplan_checkpoint"){
+        cerr<<"Error: not a floorplan checkpoint\n";
+        exit(1);
+    }
+    if(engine_name!=engine->get_name() || blocks!=num_blocks || nets!=num_nets || val!=alpha){
+        cerr<<"Error: checkpoint of "<<engine_name<<" with "<<blocks<<" blocks, "<<nets<<" nets and alpha "<<val
+            <<" mismatches the design\n";
+        exit(1);
+    }
+    // the random engine does not skip whitespace by itself
+    double elapsed;
+    if(!(checkpoint_file>>norm_area>>norm_wl>>num_samples>>best_cost>>best_legal)
+       || !(checkpoint_file>>resume_state.num_iter>>resume_state.T1>>resume_state.T>>resume_state.num_plateau)
+       || !(checkpoint_file>>elapsed>>ws>>rand_gen) || !engine->read(checkpoint_file)){
+        cerr<<"Error: truncated or malformed checkpoint\n";
+        exit(1);
+    }
+    // runtime and time limit include the runs before
+    start_wall_time -= chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(elapsed));
+    last_checkpoint_time = elapsed;
+    resumed = true;
+    cout<<"Resume SA at temperature #"<<resume_state.num_iter<<" after "<<elapsed<<" sec\n";
+}
+
+// Fast-SA initial temperature, where the average uphill operation
+// from the current floorplan is accepted with probability P
+double Floorplanner::initial_temperature()
+{
+    double P = 0.99;
+    double total_uphill = 0.;
+    int num_uphill = 0;
+    for(int i = 0; i<num_blocks*10; i++){
+        random_operation();
+        update_all_blocks();
+        double delta = cost - undo.cost;
+        if(delta > 0){
+            total_uphill += delta;
+            num_uphill++;
+        }
+        undo_operation();
+    }
+    double T1 = total_uphill / max(num_uphill, 1) / -log(P);
+    if(verbose) cout<<"Initial temperature = "<<T1<<endl;
+    return T1;
+}
+
+void Floorplanner::anneal(double T, int num_operation)
+{
+    for(int i = 0; i<num_operation; i++){
+        // cout<<"Op #"<<i+1<<"\r"<<flush;
+        if(i%256==0 && time_up()) return;
+        // randomly do an operation
+        random_operation();
+        double threshold = acceptance_threshold(T);
+        evaluate(threshold);
+        // undo the operation by probability
+        Profiler::TimePoint start = profiler.start();
+        if(!accept_operation(threshold)){
+            undo_operation();
+        }
+        profiler.stop(PHASE_ACCEPT, start);
+        // saved floorplan if it's the best
+        backup_floorplan();
+    }
+}
+
+// every worker packs one random operation on the current B*-tree in parallel
+// the first accepted operation in worker order is committed, the ones after it are
+// discarded, so rejected operations cost no sequential time as in SA
+void Floorplanner::anneal_speculative(double T, int num_operation, vector<Floorplanner*> &workers, ThreadPool &pool)
+{
+    int num_workers = workers.size();
+    vector<char> accepted(num_workers);
+    int i = 0;
+    while(i < num_operation && !time_up()){
+        pool.run(num_workers, [&](int k){
+            Floorplanner *worker = workers[k];
+            Profiler::TimePoint start = worker->profiler.start();
+            worker->engine->copy(*engine, false);
+            worker->profiler.stop(PHASE_COPY, start);
+            // the operation is judged against the committed floorplan, not the last candidate of the worker
+            worker->chip_width = chip_width;
+            worker->chip_height = chip_height;
+            worker->WL = WL;
+            worker->cost = cost;
+            worker->random_operation();
+            double threshold = worker->acceptance_threshold(T);
+            worker->evaluate(threshold);
+            start = worker->profiler.start();
+            accepted[k] = worker->accept_operation(threshold);
+            worker->profiler.stop(PHASE_ACCEPT, start);
+        });
+        int k = find(accepted.begin(), accepted.end(), 1) - accepted.begin();
+        i += min(k+1, num_workers);
+        for(int j = 0; j<=k && j<num_workers; j++){
+            stats.add(workers[j]->cost - workers[j]->undo.cost, j==k, workers[j]->complete);
+        }
+        if(k==num_workers) continue;
+        // commit the accepted operation
+        Floorplanner *worker = workers[k];
+        Profiler::TimePoint start = profiler.start();
+        engine->copy(*worker->engine, false);
+        profiler.stop(PHASE_COPY, start);
+        chip_width = worker->chip_width;
+        chip_height = worker->chip_height;
+        WL = worker->WL;
+        cost = worker->cost;
+        // saved floorplan if it's the best
+        backup_floorplan();
+    }
+}
+
+// the speculative schedule run by a copy of this floorplanner from the start of the temperature
+// has to end in the same floorplan as anneal(), unless the time limit cut either one short
+void Floorplanner::check_speculative(Floorplanner &shadow, vector<Floorplanner*> &workers, double T, int num_operation)
+{
+    ThreadPool pool(workers.size());
+    shadow.anneal_speculative(T, num_operation, workers, pool);
+    if(time_up()) return;
+    if(shadow.engine->get_hash()!=engine->get_hash() || shadow.chip_width!=chip_width || shadow.chip_height!=chip_height
+       || shadow.WL!=WL || shadow.cost!=cost || shadow.best_cost!=best_cost){
+        cerr<<"Error: speculative SA with one worker mismatches SA, cost "<<shadow.cost<<" instead of "<<cost<<endl;
+        exit(1);
+    }
+}
+
+// Metropolis criterion of the last random operation
+// accepting with probability exp(-delta/T) is the same as
+// accepting costs up to cost - T*ln(u) for a uniform random u,
+// where ln comes from a table in the common case
+double Floorplanner::acceptance_threshold(double T)
+{
+    return undo.cost + T*fast_neg_log(1. - RAND);
+}
+
+bool Floorplanner::accept_operation(double threshold)
+{
+    double delta = cost - undo.cost;
+    bool accepted = cost <= threshold;
+    stats.add(delta, accepted, complete);
+    return accepted;
+}
+
+// statistics of a replica, worker or subproblem about to be deleted
+void Floorplanner::merge_stats(const Floorplanner &fp)
+{
+    profiler.merge(fp.profiler, fp.engine->get_num_placed());
+    cost_cache.merge_stats(fp.cost_cache);
+}
+
+void Floorplanner::set_trace(fstream *file)
+{
+    trace_file = file;
+    profiler.set_enabled(true);
+    *trace_file<<"stage,iteration,wall_time,temperature,operations,accepted,acceptance_ratio,moves_per_sec,best_cost,best_legal\n";
+}
+
+// one row of the trace per temperature, elapsed is the wall time spent at it
+void Floorplanner::trace_temperature(const char *stage, int iter, double T, const AnnealStats &temp_stats, double elapsed)
+{
+    if(!trace_file) return;
+    *trace_file<<stage<<","<<iter<<","<<get_wall_time()<<","<<T<<","
+               <<temp_stats.num_operations<<","<<temp_stats.num_accepted<<","
+               <<(double)temp_stats.num_accepted / max(temp_stats.num_operations, 1)<<","
+               <<temp_stats.num_operations / max(elapsed, 1e-9)<<","
+               <<best_cost<<","<<best_legal<<"\n";
+}
+
+// the merged floorplan of clusters is only annealed at low temperatures
+void Floorplanner::refine()
+{
+    if(verbose) cout<<"Start refinement\n";
+    int num_operation = num_blocks*20;
+    int max_iter = 300;
+    // merged clusters are already compact, only small cost changes are accepted
+    double T = initial_temperature() / 1e5;
+    double r = 0.98;
+    int num_plateau = 0;
+    // the merged floorplan is usually illegal, keep improving it until a legal one is found
+    bool prev_keep_illegal = keep_illegal;
+    keep_illegal = true;
+    for(int iter = 0; iter<max_iter; iter++){
+        double prev_best_cost = best_cost;
+        double start_time = get_wall_time();
+        restore_floorplan(*this);
+        stats = AnnealStats();
+        anneal(T, num_operation);
+        trace_temperature("refine", iter, T, stats, get_wall_time() - start_time);
+        // stop if the best legal floorplan stops improving or time is up
+        if(best_cost < prev_best_cost) num_plateau = 0;
+        else num_plateau++;
+        if(best_legal && num_plateau >= plateau_window){
+            if(verbose) cout<<"Best cost has not improved for "<<num_plateau<<" temperatures\n";
+            break;
+        }
+        if(time_up()){
+            if(verbose) cout<<"Time limit reached\n";
+            break;
+        }
+        T *= r;
+    }
+    keep_illegal = prev_keep_illegal;
+}
+
+// blocks are clustered by connectivity and every cluster is floorplanned in two shapes in parallel,
+// then clusters are floorplanned as super blocks in the shape of their first floorplan,
+// and the floorplans of the shapes matching the orientation of super blocks are merged
+void Floorplanner::hierarchical_floorplan(bool sampling_mode)
+{
+    vector<vector<int>> clusters = cluster_blocks();
+    int num = clusters.size();
+    if(verbose) cout<<"Cluster "<<num_blocks<<" blocks into "<<num<<" clusters\n";
+    // clusters keep the aspect ratio of the outline with half of its white space,
+    // leaving the other half for packing super blocks
+    double total_area = 0.;
+    for(Block *block : block_list){
+        total_area += (double)block->get_width()*block->get_height();
+    }
+    double space_ratio = 1. + ((double)outline_width*outline_height / total_area - 1.) / 2.;
+    vector<Floorplanner*> floorplanners; // shape s of cluster c at 2*c+s
+    for(int c = 0; c<num; c++){
+        double area = 0.;
+        for(int id : clusters[c]){
+            area += (double)block_list[id]->get_width()*block_list[id]->get_height();
+        }
+        area *= space_ratio;
+        int width = ceil(sqrt(area / get_outline_ar()));
+        int height = ceil(area / width);
+        floorplanners.push_back(create_cluster(clusters[c], width, height, 2*c+1));
+        floorplanners.push_back(create_cluster(clusters[c], height, width, 2*c+2));
+    }
+    int num_threads = min<int>(floorplanners.size(), max<int>(1, thread::hardware_concurrency()));
+    ThreadPool pool(num_threads);
+    pool.run(floorplanners.size(), [&](int i){
+        floorplanners[i]->floorplan();
+    });
+    if(verbose) cout<<"Floorplanned "<<num<<" clusters in "<<get_wall_time()<<" sec\n";
+    // super blocks connect to each other and the terminals
+    Floorplanner *top = create_subproblem(2*num+1);
+    top->outline_width = outline_width;
+    top->outline_height = outline_height;
+    vector<int> cluster_of(num_blocks);
+    for(int c = 0; c<num; c++){
+        top->add_block("cluster"+to_string(c), floorplanners[2*c]->chip_width, floorplanners[2*c]->chip_height);
+        for(int id : clusters[c]) cluster_of[id] = c;
+    }
+    for(Terminal *term : terminal_list){
+        top->add_terminal(term->get_name(), term->get_x(), term->get_y());
+    }
+    for(int n = 0; n<num_nets; n++){
+        vector<int> block_ids, terminal_ids;
+        for(int k = net_start[n]; k<net_block_end[n]; k++){
+            block_ids.push_back(cluster_of[net_pins[k]]);
+        }
+        for(int k = net_block_end[n]; k<net_start[n+1]; k++){
+            terminal_ids.push_back(net_pins[k]-num_blocks);
+        }
+        sort(block_ids.begin(), block_ids.end());
+        block_ids.erase(unique(block_ids.begin(), block_ids.end()), block_ids.end());
+        if(!block_ids.empty() && block_ids.size()+terminal_ids.size() >= 2) top->add_net(block_ids, terminal_ids);
+    }
+    top->index_design();
+    top->floorplan();
+    if(verbose) cout<<"Floorplanned clusters as super blocks in "<<get_wall_time()<<" sec\n";
+    // a rotated super block takes the floorplan of the other shape, a square one is never rotated
+    vector<const Engine*> engines;
+    for(int c = 0; c<num; c++){
+        int width = floorplanners[2*c]->chip_width, height = floorplanners[2*c]->chip_height;
+        bool rotated = width!=height && top->engine->get_orien(c)!=(width < height);
+        engines.push_back(floorplanners[2*c+rotated]->engine);
+    }
+    engine->merge(*top->engine, engines, clusters);
+    merge_stats(*top);
+    delete top;
+    for(Floorplanner *fp : floorplanners){
+        merge_stats(*fp);
+        delete fp;
+    }
+    // blocks are placed without tracking wirelength
+    wl_cached = false;
+    update_all_blocks(sampling_mode);
+}
+
+// greedy bottom-up clustering: every pass matches each cluster, smaller ones first,
+// with the unmatched neighbor of the highest connectivity per area until num_clusters remain
+// cluster area is capped at 1.5 times the average to keep cluster floorplans balanced
+vector<vector<int>> Floorplanner::cluster_blocks() const
+{
+    vector<int> cluster_of(num_blocks);
+    vector<double> area(num_blocks);
+    double total_area = 0.;
+    for(int id = 0; id<num_blocks; id++){
+        cluster_of[id] = id;
+        area[id] = (double)block_list[id]->get_width()*block_list[id]->get_height();
+        total_area += area[id];
+    }
+    double max_area = 1.5*total_area/num_clusters;
+    int num = num_blocks;
+    while(num > num_clusters){
+        // connectivity between clusters with the clique net model
+        vector<map<int, double>> connectivity(num);
+        for(int n = 0; n<num_nets; n++){
+            vector<int> ids;
+            for(int k = net_start[n]; k<net_block_end[n]; k++) ids.push_back(cluster_of[net_pins[k]]);
+            sort(ids.begin(), ids.end());
+            ids.erase(unique(ids.begin(), ids.end()), ids.end());
+            if(ids.size() < 2) continue;
+            double weight = 1./(ids.size()-1);
+            for(int i = 0; i<ids.size(); i++){
+                for(int j = i+1; j<ids.size(); j++){
+                    connectivity[ids[i]][ids[j]] += weight;
+                    connectivity[ids[j]][ids[i]] += weight;
                 }
-                rightmost = node;
-                blkit = unplaced_blocks.erase(blkit);
             }
         }
-        
-        // place as many blocks as possible horizontally
-        while(blkit!=unplaced_blocks.end()){
-            block = *blkit;
-            block->rotate();
-            int block_y = contour.find_blk_y(block, block_list[node->id]->get_top_xy().first);
-            if(place_legal(node, block, false) && contour.get_max_height()>=block_y+block->get_height()){
-                // node->left = new Node(block);
-                new Node(block);
-                place_block(node, block, false);
-                if(!current_bst->append(node, block->get_node(), false)){
-                    cerr<<"Error: cannot append node\n";
-                    exit(1);
+        vector<int> order(num);
+        for(int c = 0; c<num; c++) order[c] = c;
+        sort(order.begin(), order.end(), [&](int c1, int c2){return area[c1] < area[c2];});
+        vector<int> match(num, -1);
+        int num_merged = 0;
+        for(int c1 : order){
+            if(match[c1]!=-1) continue;
+            int best = -1;
+            double best_score = 0.;
+            for(auto &edge : connectivity[c1]){
+                int c2 = edge.first;
+                if(match[c2]!=-1 || area[c1]+area[c2] > max_area) continue;
+                double score = edge.second / (area[c1]+area[c2]);
+                if(score > best_score){
+                    best = c2;
+                    best_score = score;
                 }
-                node = node->left;
-                blkit = unplaced_blocks.erase(blkit);
-                continue;
             }
-            else{
-                // rotate back to keep dominance relation if still fail to place
-                block->rotate();
-                if(place_legal(node, block, false)){
-                    // node->left = new Node(block);
-                    new Node(block);
-                    place_block(node, block, false);
-                    if(!current_bst->append(node, block->get_node(), false)){
-                        cerr<<"Error: cannot append node\n";
-                        exit(1);
-                    }
-                    node = node->left;
-                    blkit = unplaced_blocks.erase(blkit);
-                    continue;
-                }
+            if(best==-1) continue;
+            match[c1] = best;
+            match[best] = c1;
+            num_merged++;
+            if(num - num_merged <= num_clusters) break;
+        }
+        // merge the two smallest clusters if no connected pair fits
+        if(num_merged==0){
+            match[order[0]] = order[1];
+            match[order[1]] = order[0];
+        }
+        // relabel clusters
+        vector<int> new_id(num, -1);
+        vector<double> new_area;
+        for(int c = 0; c<num; c++){
+            if(new_id[c]!=-1) continue;
+            new_id[c] = new_area.size();
+            new_area.push_back(area[c]);
+            if(match[c]!=-1){
+                new_id[match[c]] = new_id[c];
+                new_area.back() += area[match[c]];
             }
-            blkit++;
         }
-        // no more block can fill in the remaining horizontal space
-        // the result would be a like merging several skewed trees
+        for(int id = 0; id<num_blocks; id++){
+            cluster_of[id] = new_id[cluster_of[id]];
+        }
+        area = new_area;
+        num = area.size();
     }
-    update_all_blocks(true);
+    vector<vector<int>> clusters(num);
+    for(int id = 0; id<num_blocks; id++){
+        clusters[cluster_of[id]].push_back(id);
+    }
+    return clusters;
 }
 
-// given an initial solution
-void Floorplanner::SA()
+// an empty floorplanner with the same engine and optimization settings
+Floorplanner* Floorplanner::create_subproblem(unsigned seed) const
 {
-    cout<<"Start SA optimization\n";
-    int num_iter = 1;
-    int num_operation = num_blocks*200;
-    double T = 1.;
-    double Tmin = 0.01;
+    Floorplanner *fp = new Floorplanner();
+    delete fp->engine;
+    fp->engine = engine->clone(&fp->block_list);
+    fp->alpha = alpha;
+    fp->fast_schedule = fast_schedule;
+    fp->plateau_window = plateau_window;
+    fp->time_limit = time_limit > 0 ? max(time_limit - get_wall_time(), 1e-3) : 0.;
+    fp->base_seed = base_seed + seed;
+    fp->rand_gen.seed(base_seed);
+    for(unsigned i = 0; i<seed; i++) fp->rand_gen.jump();
+    fp->keep_illegal = true;
+    fp->verbose = false;
+    fp->profiler.set_enabled(profiler.is_enabled());
+    fp->cost_cache.reset(cost_cache.get_capacity());
+    return fp;
+}
+
+// floorplanner of the blocks of a cluster with the nets among them
+Floorplanner* Floorplanner::create_cluster(const vector<int> &ids, int width, int height, unsigned seed) const
+{
+    Floorplanner *fp = create_subproblem(seed);
+    fp->outline_width = width;
+    fp->outline_height = height;
+    vector<int> local_ids(num_blocks, -1);
+    for(int id : ids){
+        local_ids[id] = fp->block_list.size();
+        fp->add_block(block_list[id]->get_name(), block_list[id]->get_width(), block_list[id]->get_height());
+    }
+    for(int n = 0; n<num_nets; n++){
+        vector<int> block_ids;
+        for(int k = net_start[n]; k<net_block_end[n]; k++){
+            int id = net_pins[k];
+            if(local_ids[id]!=-1) block_ids.push_back(local_ids[id]);
+        }
+        if(block_ids.size() >= 2) fp->add_net(block_ids, vector<int>());
+    }
+    // area alone if no net is inside the cluster
+    if(fp->net_list.empty()) fp->alpha = 1.;
+    fp->index_design();
+    return fp;
+}
+
+// replicas anneal at a ladder of fixed temperatures on separate threads
+// and exchange states between neighboring temperatures after every round
+void Floorplanner::parallel_tempering()
+{
+    if(verbose) cout<<"Start parallel tempering with "<<num_replicas<<" replicas\n";
+    // the ladder spans the start temperature of the SA schedule down to a hundredth of it,
+    // the range of geometric cooling
+    double Tmax = fast_schedule ? initial_temperature() : 1.;
+    double Tmin = Tmax * 0.01;
     double r = 0.999;
-    double delta;
-    double prob;
-    while(T > Tmin){
-        // cout<<"Iter #"<<num_iter<<endl;
-        restore_floorplan(best_bst);
-        for(int i = 0; i<num_operation; i++){
-            // cout<<"Op #"<<i+1<<"\r"<<flush;
-            // backup current floorplan
-            previous_bst->replace(current_bst);
-            // randomly do an operation
-            random_operation();
-            update_all_blocks();
-            delta = current_bst->get_cost() - previous_bst->get_cost();
-            prob = min(1., exp(-delta/T));
-            // restore undo the operation by probability
-            if(RAND > prob){
-                restore_floorplan(previous_bst);
+    // same total number of operations as SA, shared by all replicas
+    int num_operation = num_blocks*20;
+    int num_temperatures = ceil(log(Tmin/Tmax) / log(r));
+    int num_rounds = max(1, num_temperatures*10/num_replicas);
+    vector<double> temperatures;
+    vector<Floorplanner*> replicas; // ordered by temperature
+    for(int i = 0; i<num_replicas; i++){
+        temperatures.push_back(Tmax * pow(Tmin/Tmax, (double)i/(double)(num_replicas-1)));
+        replicas.push_back(create_replica(i+1));
+    }
+    ThreadPool pool(num_replicas);
+    int num_plateau = 0;
+    for(int round = 0; round<num_rounds; round++){
+        double prev_best_cost = best_cost;
+        double start_time = get_wall_time();
+        pool.run(num_replicas, [&](int i){
+            replicas[i]->anneal(temperatures[i], num_operation);
+        });
+        double elapsed = get_wall_time() - start_time;
+        vector<AnnealStats> round_stats;
+        for(Floorplanner *replica : replicas){
+            round_stats.push_back(replica->stats);
+            replica->stats = AnnealStats();
+        }
+        // Metropolis rule to exchange states of neighboring temperatures
+        for(int i = round%2; i+1<num_replicas; i+=2){
+            double cost_i = replicas[i]->cost;
+            double cost_j = replicas[i+1]->cost;
+            double prob = min(1., exp((1./temperatures[i] - 1./temperatures[i+1]) * (cost_i - cost_j)));
+            if(RAND < prob) swap(replicas[i], replicas[i+1]);
+        }
+        // keep the best legal floorplan among all replicas
+        for(Floorplanner *replica : replicas){
+            if(replica->best_cost < best_cost){
+                restore_floorplan(*replica);
+                backup_floorplan();
             }
-            // saved floorplan if it's the best
-            backup_floorplan();
         }
-        // cout<<endl;
-        num_iter++;
-        // reduce temperature
-        T *= r;
+        for(int i = 0; i<num_replicas; i++){
+            trace_temperature("pt", round, temperatures[i], round_stats[i], elapsed);
+        }
+        // stop if the best legal floorplan stops improving or time is up
+        // a round has a tenth of the operations of a SA temperature
+        if(best_cost < prev_best_cost) num_plateau = 0;
+        else num_plateau++;
+        if((best_legal || keep_illegal) && num_plateau >= plateau_window*10){
+            if(verbose) cout<<"Best cost has not improved for "<<num_plateau<<" rounds\n";
+            break;
+        }
+        if(time_up()){
+            if(verbose) cout<<"Time limit reached\n";
+            break;
+        }
+    }
+    for(Floorplanner *replica : replicas){
+        merge_stats(*replica);
+        delete replica;
     }
 }
 
-void Floorplanner::print_placed_blocks()
+// a replica owns copies of blocks and nets so it can be packed independently
+Floorplanner* Floorplanner::create_replica(unsigned seed) const
 {
-    cout<<"All placed blocks:\n";
-    Node *node = current_bst->get_root();
-    print_bst_dfs(node);
+    Floorplanner *replica = new Floorplanner(*this);
+    replica->copy_design();
+    replica->engine = engine->clone(&replica->block_list);
+    replica->base_seed = base_seed + seed;
+    // replica i takes the i-th stream of the seed
+    replica->rand_gen.seed(base_seed);
+    for(unsigned i = 0; i<seed; i++) replica->rand_gen.jump();
+    replica->verbose = false;
+    // replicas start profiling and caching from scratch, their statistics are merged back by their owner
+    replica->profiler.reset();
+    replica->trace_file = nullptr;
+    replica->best_trajectory.clear();
+    replica->cost_cache.reset(cost_cache.get_capacity());
+    return replica;
+}
+
+void Floorplanner::copy_design()
+{
+    for(Block *&block : block_list){
+        block = new Block(*block);
+    }
+    for(Terminal *&term : terminal_list){
+        term = new Terminal(*term);
+    }
+    for(Net *&net : net_list){
+        Net *new_net = new Net(net->get_id());
+        for(Terminal *term : net->get_terminals()){
+            Block *block = dynamic_cast<Block*>(term);
+            if(block) new_net->add_terminal(block_list[block->get_id()]);
+            else new_net->add_terminal(terminal_list[term->get_id()]);
+        }
+        net = new_net;
+    }
 }
 
-void Floorplanner::print_bst_dfs(Node *node)
+void Floorplanner::print_placed_blocks()
 {
-    block_list[node->id]->print();
-    // if(node->parent) cout<<"parent: "<<block_list[node->parent->id]->get_name()<<endl;
-    if(node->left) print_bst_dfs(node->left);
-    if(node->right) print_bst_dfs(node->right);
+    cout<<"All placed blocks:\n";
+    vector<int> order;
+    engine->get_order(order);
+    for(int id : order){
+        block_list[id]->print();
+    }
 }
 
 bool Floorplanner::check_outline()
@@ -381,41 +902,125 @@ bool Floorplanner::check_outline()
     return ids.empty();
 }
 
-void Floorplanner::check_overlap()
+// sweep a vertical line over the blocks from left to right, keeping the y intervals
+// of blocks crossing the line ordered in a set: intervals stay disjoint as long as no
+// overlap is found, so a block reaching the line is only compared with its two neighbors
+// an overlapping block is reported once and left out of the set
+bool Floorplanner::check_overlap()
 {
-    for(Block *b1 : block_list){
-        for(Block *b2 : block_list){
-            if(b1==b2) continue;
-            // overlap if one of the corner of b1 lies within b2
-            if(block_overlap(b1, b2))
-            {
-                cerr<<"Error: the following 2 blocks are overlapping\n";
-                b1->print();
-                b2->print();
-            }
+    vector<int> order(num_blocks);
+    for(int id = 0; id<num_blocks; id++) order[id] = id;
+    sort(order.begin(), order.end(), [&](int id1, int id2){
+        return block_list[id1]->get_x() < block_list[id2]->get_x();
+    });
+    set<pair<int, int>> crossing; // lower y and id of blocks crossing the line
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> right_edges;
+    bool legal = true;
+    for(int id : order){
+        Block *block = block_list[id];
+        // blocks ending at the left edge only touch the new one
+        while(!right_edges.empty() && right_edges.top().first <= block->get_x()){
+            int prev_id = right_edges.top().second;
+            right_edges.pop();
+            crossing.erase(make_pair(block_list[prev_id]->get_y(), prev_id));
+        }
+        auto above = crossing.lower_bound(make_pair(block->get_y(), -1));
+        int overlap_id = -1;
+        if(above!=crossing.end() && above->first < block->get_top_xy().second){
+            overlap_id = above->second;
+        }
+        else if(above!=crossing.begin() && block_list[prev(above)->second]->get_top_xy().second > block->get_y()){
+            overlap_id = prev(above)->second;
+        }
+        if(overlap_id!=-1){
+            cerr<<"Error: the following 2 blocks are overlapping\n";
+            block_list[overlap_id]->print();
+            block->print();
+            legal = false;
+            continue;
         }
+        crossing.emplace(block->get_y(), id);
+        right_edges.emplace(block->get_top_xy().first, id);
     }
+    return legal;
+}
+
+void Floorplanner::add_block(const string &name, int width, int height)
+{
+    int id = block_list.size();
+    blkname2id[name] = id;
+    block_list.push_back(new Block(id, name, width, height));
+}
+
+void Floorplanner::add_terminal(const string &name, int x, int y)
+{
+    int id = terminal_list.size();
+    terminalname2id[name] = id;
+    terminal_list.push_back(new Terminal(id, name, x, y));
 }
 
-bool Floorplanner::block_overlap(Block *b1, Block *b2)
+void Floorplanner::add_net(const vector<int> &block_ids, const vector<int> &terminal_ids)
 {
-    // overlap if one of the corner of b1 lies within b2 or vise versa
-    int b1x1, b1y1;
-    int b1x2, b1y2;
-    int b2x1, b2y1;
-    int b2x2, b2y2;
-    tie(b1x1, b1y1) =  b1->get_low_xy();
-    tie(b1x2, b1y2) =  b1->get_top_xy();
-    tie(b2x1, b2y1) =  b2->get_low_xy();
-    tie(b2x2, b2y2) =  b2->get_top_xy();
+    Net *net = new Net(net_list.size());
+    terminal_bbox.emplace_back();
+    for(int id : block_ids){
+        net->add_terminal(block_list[id]);
+        net_pins.push_back(id);
+    }
+    net_block_end.push_back(net_pins.size());
+    for(int id : terminal_ids){
+        Terminal *term = terminal_list[id];
+        net->add_terminal(term);
+        net_pins.push_back(id);
+        terminal_bbox.back().add(term->get_x(), term->get_y());
+    }
+    net_start.push_back(net_pins.size());
+    net_list.push_back(net);
+}
 
-    bool hor_overlap_1 = (b1x1 >= b2x1 && b1x1 < b2x2 || b1x2 > b2x1 && b1x2 <= b2x2);
-    bool ver_overlap_1 = (b1y1 >= b2y1 && b1y1 < b2y2 || b1y2 > b2y1 && b1y2 <= b2y2);
-    bool hor_overlap_2 = (b2x1 >= b1x1 && b2x1 < b1x2 || b2x2 > b1x1 && b2x2 <= b1x2);
-    bool ver_overlap_2 = (b2y1 >= b1y1 && b2y1 < b1y2 || b2y2 > b1y1 && b2y2 <= b1y2);
-    if(hor_overlap_1 && ver_overlap_1) return true;
-    if(hor_overlap_2 && ver_overlap_2) return true;
-    return false;
+// counts and net index of a design built by the add methods
+void Floorplanner::index_design()
+{
+    num_blocks = block_list.size();
+    num_terminals = terminal_list.size();
+    num_nets = net_list.size();
+    // terminal pins follow block pins
+    pin_x.assign(num_blocks+num_terminals, 0.);
+    pin_y.assign(num_blocks+num_terminals, 0.);
+    for(int id = 0; id<num_terminals; id++){
+        pin_x[num_blocks+id] = terminal_list[id]->get_x();
+        pin_y[num_blocks+id] = terminal_list[id]->get_y();
+    }
+    for(int n = 0; n<num_nets; n++){
+        for(int k = net_block_end[n]; k<net_start[n+1]; k++){
+            net_pins[k] += num_blocks;
+        }
+    }
+    // count nets of every block, then fill them in net order
+    block_net_start.assign(num_blocks+1, 0);
+    vector<int> last_net(num_blocks, -1);
+    for(int n = 0; n<num_nets; n++){
+        for(int k = net_start[n]; k<net_block_end[n]; k++){
+            int id = net_pins[k];
+            if(last_net[id]==n) continue;
+            last_net[id] = n;
+            block_net_start[id+1]++;
+        }
+    }
+    for(int id = 0; id<num_blocks; id++){
+        block_net_start[id+1] += block_net_start[id];
+    }
+    block_nets.resize(block_net_start[num_blocks]);
+    vector<int> fill(block_net_start.begin(), block_net_start.end()-1);
+    last_net.assign(num_blocks, -1);
+    for(int n = 0; n<num_nets; n++){
+        for(int k = net_start[n]; k<net_block_end[n]; k++){
+            int id = net_pins[k];
+            if(last_net[id]==n) continue;
+            last_net[id] = n;
+            block_nets[fill[id]++] = n;
+        }
+    }
 }
 
 void Floorplanner::parse_block(fstream &block_file)
@@ -447,11 +1052,10 @@ void Floorplanner::parse_block(fstream &block_file)
                     cerr<<"Terminal "<<sbuf<<" duplicates in .block file\n";
                     exit(1);
                 }
-                terminalname2id[sbuf] = terminal_id;
                 string terminal_x, terminal_y;
                 block_file>>terminal_x;
                 block_file>>terminal_y;
-                terminal_list.push_back(new Terminal(terminal_id, sbuf, stoi(terminal_x), stoi(terminal_y)));
+                add_terminal(sbuf, stoi(terminal_x), stoi(terminal_y));
                 terminal_id++;
             }
             else{
@@ -459,10 +1063,9 @@ void Floorplanner::parse_block(fstream &block_file)
                     cerr<<"Block "<<sbuf<<" duplicates in .block file\n";
                     exit(1);
                 }
-                blkname2id[sbuf] = block_id;
                 string block_height;
                 block_file>>block_height;
-                block_list.push_back(new Block(block_id, sbuf, stoi(block_width), stoi(block_height)));
+                add_block(sbuf, stoi(block_width), stoi(block_height));
                 block_id++;
             }
         }
@@ -491,7 +1094,7 @@ void Floorplanner::parse_net(fstream &net_file)
         else if(sbuf == "NetDegree:"){
             net_file>>sbuf;
             int degree = stoi(sbuf);
-            Net *net = new Net(net_id);
+            vector<int> block_ids, terminal_ids;
             for(int i = 0; i<degree; i++){
                 net_file>>sbuf;
                 Name2Id::iterator blk_it = blkname2id.find(sbuf);
@@ -503,13 +1106,13 @@ void Floorplanner::parse_net(fstream &net_file)
                     exit(1);
                 }
                 else if(has_block){
-                    net->add_terminal(block_list[blk_it->second]);
+                    block_ids.push_back(blk_it->second);
                 }
                 else if(has_terminal){
-                    net->add_terminal(terminal_list[terminal_it->second]);
+                    terminal_ids.push_back(terminal_it->second);
                 }
             }
-            net_list.push_back(net);
+            add_net(block_ids, terminal_ids);
             net_id++;
         }
     }
@@ -517,23 +1120,103 @@ void Floorplanner::parse_net(fstream &net_file)
         cerr<<"Wrong net number in .nets file\n";
         exit(1);
     }
+    index_design();
     cout<<"Total "<<num_nets<<" nets added successfully\n";
     cout<<endl;
 }
 
 void Floorplanner::floorplan()
 {
-    BlockList unplaced_blocks(block_list.begin(), block_list.end());
-    initial_floorplan(unplaced_blocks);
-    cout<<"Initial floorplan:\n";
-    backup_floorplan(true);
-    sample_normalized_cost();
-    restore_floorplan(best_bst);
+    if(resumed){
+        // trees and normalization come from the checkpoint
+        update_all_blocks();
+        SA();
+        restore_floorplan(*this);
+        if(verbose){
+            check_outline();
+            check_overlap();
+        }
+        return;
+    }
+    bool hierarchical = num_clusters > 1 && num_clusters < num_blocks;
+    // an alpha sweep samples once for all of its floorplanners
+    bool sampled = num_samples > 0;
+    if(hierarchical) hierarchical_floorplan(!sampled);
+    else initial_floorplan(!sampled);
+    if(verbose) cout<<"Initial floorplan:\n";
     backup_floorplan(true);
-    SA();
-    restore_floorplan(best_bst);
-    check_outline();
-    check_overlap();
+    // a single block has nothing to optimize
+    if(num_blocks > 1){
+        if(!sampled) sample_normalized_cost();
+        restore_floorplan(*this);
+        backup_floorplan(true);
+        bool flat = !hierarchical;
+        if(hierarchical){
+            refine();
+            // clusters may not fit in the outline together, start over from a flat floorplan
+            // unless there is no time left to improve on the refined one
+            if(!best_legal && !time_up()){
+                if(verbose) cout<<"Hierarchical floorplan is illegal, fall back to flat floorplanning\n";
+                initial_floorplan(false);
+                backup_floorplan(true);
+                flat = true;
+            }
+        }
+        if(flat){
+            if(num_replicas > 1) parallel_tempering();
+            else SA();
+        }
+    }
+    restore_floorplan(*this);
+    if(verbose){
+        check_outline();
+        check_overlap();
+    }
+}
+
+// floorplanners of every alpha value run in parallel on copies of the parsed design,
+// sharing the normalization samples of random walks from the initial floorplan
+vector<Floorplanner*> Floorplanner::sweep_alpha(const vector<double> &alphas)
+{
+    vector<Floorplanner*> results;
+    for(double val : alphas){
+        Floorplanner *fp = create_replica(0);
+        fp->set_alpha(val);
+        results.push_back(fp);
+    }
+    if(num_blocks > 1){
+        initial_floorplan();
+        sample_normalized_cost();
+        for(Floorplanner *fp : results){
+            fp->norm_area = norm_area;
+            fp->norm_wl = norm_wl;
+            fp->num_samples = num_samples;
+        }
+    }
+    int num_threads = min<int>(alphas.size(), max<int>(1, thread::hardware_concurrency()));
+    ThreadPool pool(num_threads);
+    pool.run(results.size(), [&](int i){
+        results[i]->floorplan();
+    });
+    return results;
+}
+
+// results of an alpha sweep with the legal ones not dominated in both area and wirelength marked
+void Floorplanner::write_pareto(fstream &output, const vector<Floorplanner*> &results)
+{
+    output<<fixed;
+    output<<"alpha area wirelength chip_width chip_height legal pareto\n";
+    for(Floorplanner *fp : results){
+        bool pareto = fp->is_legal();
+        for(Floorplanner *other : results){
+            if(!pareto) break;
+            if(!other->is_legal()) continue;
+            if(other->get_area() <= fp->get_area() && other->get_wl() <= fp->get_wl()
+                && (other->get_area() < fp->get_area() || other->get_wl() < fp->get_wl())) pareto = false;
+        }
+        output<<fp->alpha<<" "<<fp->get_area()<<" "<<fp->get_wl()<<" "<<fp->chip_width<<" "<<fp->chip_height
+              <<" "<<fp->is_legal()<<" "<<pareto<<"\n";
+    }
 }
 
 void Floorplanner::plot(string file_name)
@@ -588,7 +1271,7 @@ void Floorplanner::write_result(fstream &output)
     output<<get_area()<<"\n";
     output<<chip_width<<" "<<chip_height<<"\n";
     // runtime
-    output<<get_time()<<"\n";
+    output<<get_wall_time()<<"\n";
     // report macros
     for(Block *block : block_list){
         int x1,x2,y1,y2;
@@ -598,6 +1281,106 @@ void Floorplanner::write_result(fstream &output)
     }
 }
 
+// phase profile of the whole run in JSON, including replicas, workers and clusters,
+// with the best cost trajectory of this floorplanner
+void Floorplanner::write_profile(fstream &output)
+{
+    double wall_time = get_wall_time();
+    long long num_moves = profiler.get_count(PHASE_OPERATION);
+    output<<"{\n";
+    output<<"  \"wall_time\": "<<wall_time<<",\n";
+    output<<"  \"moves\": "<<num_moves<<",\n";
+    output<<"  \"moves_per_sec\": "<<num_moves / max(wall_time, 1e-9)<<",\n";
+    output<<"  \"blocks_placed\": "<<profiler.get_num_placed() + engine->get_num_placed()<<",\n";
+    output<<"  \"cache_lookups\": "<<cost_cache.get_num_lookups()<<",\n";
+    output<<"  \"cache_hit_rate\": "<<cost_cache.get_hit_rate()<<",\n";
+    output<<"  \"phases\": ";
+    profiler.write_json(output);
+    output<<",\n  \"best_cost\": [";
+    for(size_t i = 0; i<best_trajectory.size(); i++){
+        output<<(i ? ",\n    " : "\n    ")<<"["<<get<0>(best_trajectory[i])<<", "<<get<1>(best_trajectory[i])
+              <<", "<<(get<2>(best_trajectory[i]) ? "true" : "false")<<"]";
+    }
+    output<<(best_trajectory.empty() ? "]\n" : "\n  ]\n");
+    output<<"}\n";
+}
+
+// validate a result of this design: every block is reported once in its dimension or rotated,
+// inside the outline without overlap, and the reported figures agree with the placement
+bool Floorplanner::check_result(fstream &result_file)
+{
+    double cost, wl, runtime;
+    long long area;
+    int width, height;
+    if(!(result_file>>cost>>wl>>area>>width>>height>>runtime)){
+        cerr<<"Error: missing cost, wirelength, area, chip dimension or runtime in the result\n";
+        return false;
+    }
+    bool valid = true;
+    vector<char> placed(num_blocks, 0);
+    chip_width = 0;
+    chip_height = 0;
+    string name;
+    int x1, y1, x2, y2;
+    while(result_file>>name>>x1>>y1>>x2>>y2){
+        Name2Id::iterator it = blkname2id.find(name);
+        if(it==blkname2id.end()){
+            cerr<<"Error: unknown block \""<<name<<"\" in the result\n";
+            valid = false;
+            continue;
+        }
+        Block *block = block_list[it->second];
+        if(placed[it->second]){
+            cerr<<"Error: block "<<name<<" is placed more than once\n";
+            valid = false;
+            continue;
+        }
+        placed[it->second] = 1;
+        if(x2-x1!=block->get_width() && x2-x1==block->get_height()) block->rotate();
+        if(x2-x1!=block->get_width() || y2-y1!=block->get_height()){
+            cerr<<"Error: block "<<name<<" is placed in dimension ("<<x2-x1<<","<<y2-y1<<")\n";
+            valid = false;
+        }
+        block->set_x(x1);
+        block->set_y(y1);
+        chip_width = max(chip_width, x2);
+        chip_height = max(chip_height, y2);
+    }
+    if(!result_file.eof()){
+        cerr<<"Error: malformed block line in the result\n";
+        return false;
+    }
+    for(int id = 0; id<num_blocks; id++){
+        if(!placed[id]){
+            cerr<<"Error: block "<<block_list[id]->get_name()<<" is not placed\n";
+            valid = false;
+        }
+    }
+    if(!valid) return false;
+    wl_cached = false;
+    update_wl();
+    if(width!=chip_width || height!=chip_height){
+        cerr<<"Error: reported chip dimension ("<<width<<","<<height<<") mismatches ("<<chip_width<<","<<chip_height<<")\n";
+        valid = false;
+    }
+    if(area!=(long long)chip_width*chip_height){
+        cerr<<"Error: reported chip area "<<area<<" mismatches "<<(long long)chip_width*chip_height<<"\n";
+        valid = false;
+    }
+    // figures are written with 6 decimal places
+    if(abs(wl - get_wl()) > 1e-6*max(1., get_wl())){
+        cerr<<"Error: reported wirelength "<<wl<<" mismatches "<<get_wl()<<"\n";
+        valid = false;
+    }
+    if(abs(cost - get_cost()) > 1e-6*max(1., get_cost())){
+        cerr<<"Error: reported cost "<<cost<<" mismatches "<<get_cost()<<"\n";
+        valid = false;
+    }
+    valid = check_outline() && valid;
+    valid = check_overlap() && valid;
+    return valid;
+}
+
 void Floorplanner::print_summary(int verbose)
 {
     if(verbose > 0){
@@ -607,7 +1390,10 @@ void Floorplanner::print_summary(int verbose)
         cout<<"Total wire length = "<<get_wl()<<"\n";
         cout<<"Normalized cost = "<<get_normalized_cost()<<"\n";
         print_placed_blocks();
-        cout<<"Program runtime: "<<get_time()<<" sec\n";
+        if(cost_cache.is_enabled()){
+            cout<<"Cost cache hit rate = "<<cost_cache.get_hit_rate()*100.<<"% of "<<cost_cache.get_num_lookups()<<" evaluations\n";
+        }
+        cout<<"Program runtime: "<<get_wall_time()<<" sec\n";
         cout<<endl;
     }
     else{
@@ -615,7 +1401,7 @@ void Floorplanner::print_summary(int verbose)
         cout<<"Chip area = "<<get_area()<<"\t";
         cout<<"Total wire length = "<<get_wl()<<"\t";
         cout<<"Normalized cost = "<<get_normalized_cost()<<"\t";
-        cout<<"Program runtime: "<<get_time()<<" sec\n"<<flush;
+        cout<<"Program runtime: "<<get_wall_time()<<" sec\n"<<flush;
     }
 }
 
@@ -630,5 +1416,7 @@ void Floorplanner::clear()
     for (size_t i = 0, end = net_list.size(); i < end; ++i) {
         delete net_list[i];
     }
+    delete engine;
+    engine = nullptr;
     return;
 }
@@ -1,23 +1,84 @@
 #include "BSTree.h"
+#include "SeqPair.h"
+#include "threadpool.h"
+#include "profiler.h"
+#include "costcache.h"
 #include <fstream>
 #include <map>
+#include <set>
+#include <queue>
 #include <cassert>
 #include <ctime>
-#include <queue>
 #include <random>
 #include <cmath>
 #include <tuple>
+#include <chrono>
+#include <iomanip>
+#include <cstdio>
 
 using namespace std;
 
 // Definition of dimensions: width->horizontal, height->vertical
 
 typedef map<string, int> Name2Id;
-typedef vector<Block*> BlockList;
 typedef tuple<int, int, int, bool> OP;
 
+// statistics of the operations at one temperature
+struct AnnealStats
+{
+    int num_operations;
+    int num_accepted;
+    int num_evaluated; // operations whose packing did not stop early
+    double total_delta; // sum of absolute cost changes of the evaluated operations
+    AnnealStats() : num_operations(0), num_accepted(0), num_evaluated(0), total_delta(0.) {}
+    // the cost of an operation stopped early is a lower bound, its change is left out
+    void add(double delta, bool accepted, bool evaluated){
+        num_operations++;
+        num_accepted += accepted;
+        if(!evaluated) return;
+        num_evaluated++;
+        total_delta += abs(delta);
+    }
+};
+
+// progress of SA at the start of a temperature, kept in checkpoints
+struct SAState
+{
+    int num_iter;
+    double T1; // initial temperature
+    double T;
+    int num_plateau;
+};
+
+// bounding box of pin centers
+struct BBox
+{
+    double x1;
+    double y1;
+    double x2;
+    double y2;
+    BBox() : x1(INT_MAX), y1(INT_MAX), x2(0), y2(0) {}
+    void add(double x, double y){
+        x1 = min(x1, x);
+        x2 = max(x2, x);
+        y1 = min(y1, y);
+        y2 = max(y2, y);
+    }
+    double hpwl() const{return x2-x1 + y2-y1;}
+};
+
+// floorplan before the last random operation
+struct UndoRecord
+{
+    int chip_width;
+    int chip_height;
+    double WL;
+    double cost;
+};
+
 class Floorplanner
 {
+    friend class FloorplanInstance; // in-memory designs of the library interface
     double alpha;   // evaluation: alpha*A + (1-alpha)*WL
     int outline_width;
     int outline_height;
@@ -35,21 +96,65 @@ class Floorplanner
     vector<Net*> net_list;
     Name2Id blkname2id;
     Name2Id terminalname2id;
-    Contour contour;
-    BST *current_bst;
-    BST *best_bst;
-    BST *previous_bst;
-    clock_t start_time;
-    default_random_engine rand_gen;
-    uniform_real_distribution<double> unif;
+    Engine *engine; // floorplan representation
+    double cost; // normalized cost of the current floorplan
+    bool complete; // false if packing stopped early and cost is only a lower bound
+    double best_cost;
+    UndoRecord undo;
+    vector<int> moved_blocks; // blocks moved since the last wirelength update
+    // pin positions of all blocks then all terminals, block centers are copied after packing
+    vector<double> pin_x;
+    vector<double> pin_y;
+    // nets in compressed rows: pins of net n are net_pins[net_start[n]..net_start[n+1]),
+    // block pins first and terminal pins from net_block_end[n]
+    vector<int> net_start;
+    vector<int> net_block_end;
+    vector<int> net_pins;
+    // nets of block id are block_nets[block_net_start[id]..block_net_start[id+1])
+    vector<int> block_net_start;
+    vector<int> block_nets;
+    // incremental wirelength
+    vector<BBox> terminal_bbox; // fixed terminals of each net
+    vector<BBox> net_bbox;
+    vector<int> net_stamp; // last update of each net
+    int wl_stamp;
+    double packed_wl; // wirelength of the packed blocks
+    double terminal_wl; // wirelength of the fixed terminals, a lower bound of any floorplan
+    bool wl_cached;
+    CostCache cost_cache; // evaluations of recently packed representations
+    // parallel tempering
+    int num_replicas;
+    // speculative SA
+    int num_speculations;
+    // parallel cost normalization
+    int num_sample_threads;
+    // hierarchical floorplanning
+    int num_clusters;
+    // cooling schedule and stopping criteria
+    bool fast_schedule; // Fast-SA three-stage schedule, otherwise geometric cooling
+    int plateau_window; // temperatures without improvement before stopping
+    double time_limit; // wall time limit in seconds, 0 for none
+    bool best_legal; // whether the best floorplan is legal
+    bool keep_illegal; // keep the best illegal floorplan if none is legal
+    AnnealStats stats;
+    bool verbose; // report new best floorplans
+    double last_print_time; // console reports are throttled to one per second
+    // tracing
+    Profiler profiler;
+    fstream *trace_file; // per-temperature statistics in CSV, not owned
+    double last_trace_time;
+    vector<tuple<double, double, bool>> best_trajectory; // wall time, cost and legality of new best floorplans
+    // checkpointing
+    string checkpoint_name; // empty for none
+    double checkpoint_interval; // seconds of wall time between checkpoints
+    double last_checkpoint_time;
+    bool resumed; // SA continues from the state of a checkpoint
+    SAState resume_state;
+    chrono::steady_clock::time_point start_wall_time;
+    unsigned base_seed; // replicas and subproblems are seeded relative to it
+    RandomEngine rand_gen;
 
     // query
-    bool place_legal(Node *parent, Block *block, bool LR=false){
-        if(parent==nullptr) return block->get_width() <= outline_width;
-        else if(LR) return block_list[parent->id]->get_low_xy().first + block->get_width() <= outline_width;
-        else return block_list[parent->id]->get_top_xy().first + block->get_width() <= outline_width;
-    }
-    vector<int> get_highest_placed_block_ids() const;
     int get_chip_width() const{return chip_width;}
     int get_chip_height() const{return chip_height;}
     bool is_legal() const{return get_chip_width() <= outline_width && get_chip_height() <= outline_height;}
@@ -64,26 +169,57 @@ class Floorplanner
         else
             return alpha*(double)get_area()/norm_area + (1.-alpha)*get_wl()/norm_wl + abs(get_outline_ar()-get_chip_ar());
     }
+    // cost bound of any floorplan containing the blocks packed so far
+    double get_cost_lower_bound() const{return alpha*(double)get_area()/norm_area + (1.-alpha)*terminal_wl/norm_wl;}
+    double get_max_area(double threshold) const;
     // method
-    void place_block(Node *node, Block *block, bool LR=false);
-    void update_all_blocks(bool sampling_node=false);
-    void update_block_dfs(Node *node);
-    void calculate_wl();    
+    bool update_all_blocks(bool sampling_node=false, double threshold=HUGE_VAL);
+    void evaluate(double threshold);
+    double calculate_wl() const;
+    void update_wl();
+    void update_net_bbox(int net_id);
+    void update_pin(int id){
+        Block *block = block_list[id];
+        pin_x[id] = block->get_x() + block->get_width()/2.;
+        pin_y[id] = block->get_y() + block->get_height()/2.;
+    }
     void backup_floorplan(bool force=false);
-    void restore_floorplan(BST *tree);
-    void restore_block_node(Node *node);
+    void restore_floorplan(const Floorplanner &source);
     void random_operation();
+    void undo_operation();
     void sample_normalized_cost();
+    void sample_normalized_cost_parallel();
     void update_normalized_cost();
+    // design construction
+    void add_block(const string &name, int width, int height);
+    void add_terminal(const string &name, int x, int y);
+    void add_net(const vector<int> &block_ids, const vector<int> &terminal_ids);
+    void index_design();
     // algorithm
-    void initial_floorplan(BlockList &unplaced_blocks);
+    void initial_floorplan(bool sampling_mode = true);
     void SA();
+    void write_checkpoint(const SAState &state);
+    void anneal(double T, int num_operation);
+    void anneal_speculative(double T, int num_operation, vector<Floorplanner*> &workers, ThreadPool &pool);
+    void check_speculative(Floorplanner &shadow, vector<Floorplanner*> &workers, double T, int num_operation);
+    double acceptance_threshold(double T);
+    bool accept_operation(double threshold);
+    double initial_temperature();
+    bool time_up() const{return time_limit > 0 && get_wall_time() > time_limit;}
+    void parallel_tempering();
+    Floorplanner* create_replica(unsigned seed) const;
+    void copy_design();
+    void hierarchical_floorplan(bool sampling_mode = true);
+    vector<vector<int>> cluster_blocks() const;
+    Floorplanner* create_subproblem(unsigned seed) const;
+    Floorplanner* create_cluster(const vector<int> &ids, int width, int height, unsigned seed) const;
+    void refine();
+    void merge_stats(const Floorplanner &fp);
+    void trace_temperature(const char *stage, int iter, double T, const AnnealStats &temp_stats, double elapsed);
     // sanity check
     void print_placed_blocks();
-    void print_bst_dfs(Node *node);
     bool check_outline();
-    void check_overlap();
-    bool block_overlap(Block *b1, Block *b2);
+    bool check_overlap();
 public:
     Floorplanner():
     alpha(0.),
@@ -98,15 +234,36 @@ public:
     num_samples(0),
     norm_area(0.),
     norm_wl(0.),
-    current_bst(new BST),
-    best_bst(new BST),
-    previous_bst(new BST),
-    start_time(clock()),
-    rand_gen(default_random_engine(0)),
-    unif(uniform_real_distribution<double>(0., 0.999999))
-    {
-        contour.reset();
-    }
+    engine(new BSTEngine(&block_list)),
+    cost(INT_MAX),
+    complete(true),
+    best_cost(INT_MAX),
+    net_start(1, 0),
+    wl_stamp(0),
+    packed_wl(0.),
+    terminal_wl(0.),
+    wl_cached(false),
+    cost_cache(4096),
+    num_replicas(1),
+    num_speculations(1),
+    num_sample_threads(1),
+    num_clusters(0),
+    fast_schedule(true),
+    plateau_window(50),
+    time_limit(0.),
+    best_legal(false),
+    keep_illegal(false),
+    verbose(true),
+    last_print_time(-HUGE_VAL),
+    trace_file(nullptr),
+    last_trace_time(0.),
+    checkpoint_interval(5.),
+    last_checkpoint_time(0.),
+    resumed(false),
+    start_wall_time(chrono::steady_clock::now()),
+    base_seed(0),
+    rand_gen(0)
+    {}
     ~Floorplanner(){clear();}
     // necessary inputs
     void parse_block(fstream &block_file);
@@ -119,13 +276,83 @@ public:
         alpha = val;
         cout<<"Set alpha value="<<alpha<<endl;
     }
+    double get_alpha() const{return alpha;}
+    void set_num_replicas(int val){
+        if(val<1){
+            cerr<<"Number of replicas has to be positive\n";
+            exit(1);
+        }
+        num_replicas = val;
+    }
+    void set_num_speculations(int val){
+        if(val<1){
+            cerr<<"Number of speculative operations has to be positive\n";
+            exit(1);
+        }
+        num_speculations = val;
+    }
+    void set_num_sample_threads(int val){
+        if(val<1){
+            cerr<<"Number of sampling threads has to be positive\n";
+            exit(1);
+        }
+        num_sample_threads = val;
+    }
+    // representation: "bstree" or "seqpair"
+    void set_engine(const string &name){
+        if(name!="bstree" && name!="seqpair"){
+            cerr<<"Unknown floorplan representation "<<name<<"\n";
+            exit(1);
+        }
+        delete engine;
+        if(name=="seqpair") engine = new SPEngine(&block_list);
+        else engine = new BSTEngine(&block_list);
+    }
+    void set_num_clusters(int val){
+        if(val<0){
+            cerr<<"Number of clusters has to be non-negative\n";
+            exit(1);
+        }
+        num_clusters = val;
+    }
+    void set_cache_size(int val){
+        if(val<0){
+            cerr<<"Cost cache size has to be non-negative\n";
+            exit(1);
+        }
+        cost_cache.reset(val);
+    }
+    void set_seed(unsigned val){
+        base_seed = val;
+        rand_gen.seed(val);
+    }
+    void set_fast_schedule(bool val){fast_schedule = val;}
+    void set_plateau_window(int val){plateau_window = val;}
+    void set_time_limit(double val){time_limit = val;}
+    // enables profiling and writes a row of statistics per temperature to the file
+    void set_trace(fstream *file);
+    // SA writes its state to the file at most every interval seconds
+    void set_checkpoint(const string &name, double interval){
+        if(interval<0){
+            cerr<<"Checkpoint interval has to be non-negative\n";
+            exit(1);
+        }
+        checkpoint_name = name;
+        checkpoint_interval = interval;
+    }
+    // continue SA from a checkpoint of the same design, engine and alpha
+    void resume(fstream &checkpoint_file);
     // floorplanning
     void floorplan();
+    vector<Floorplanner*> sweep_alpha(const vector<double> &alphas);
+    static void write_pareto(fstream &output, const vector<Floorplanner*> &results);
     // stream out files
     void plot(string file_name);
     void write_result(fstream &output_file);
+    bool check_result(fstream &result_file);
+    void write_profile(fstream &output);
     // show info
     void print_summary(int verbose=0);
-    double get_time() const {return (double)(clock() - start_time) / CLOCKS_PER_SEC;}
+    double get_wall_time() const {return chrono::duration<double>(chrono::steady_clock::now() - start_wall_time).count();}
     void clear();
 };
@@ -0,0 +1,129 @@
+#include "fplib.h"
+#include "floorplanner.h"
+
+using namespace std;
+
+FloorplanInstance::FloorplanInstance(int outline_width, int outline_height, double alpha)
+    : fp(new Floorplanner()), indexed(false)
+{
+    if(outline_width<=0 || outline_height<=0){
+        cerr<<"Outline dimension has to be positive\n";
+        exit(1);
+    }
+    if(alpha>1 || alpha<0){
+        cerr<<"Alpha value error: has to be within interval [0,1]\n";
+        exit(1);
+    }
+    fp->outline_width = outline_width;
+    fp->outline_height = outline_height;
+    fp->alpha = alpha;
+    fp->verbose = false;
+}
+
+FloorplanInstance::~FloorplanInstance()
+{
+    delete fp;
+}
+
+int FloorplanInstance::add_block(int width, int height)
+{
+    if(indexed){
+        cerr<<"Blocks have to be added before floorplanning\n";
+        exit(1);
+    }
+    if(width<=0 || height<=0){
+        cerr<<"Block dimension has to be positive\n";
+        exit(1);
+    }
+    int id = fp->block_list.size();
+    fp->add_block("b"+to_string(id), width, height);
+    return id;
+}
+
+int FloorplanInstance::add_terminal(int x, int y)
+{
+    if(indexed){
+        cerr<<"Terminals have to be added before floorplanning\n";
+        exit(1);
+    }
+    int id = fp->terminal_list.size();
+    fp->add_terminal("t"+to_string(id), x, y);
+    return id;
+}
+
+void FloorplanInstance::add_net(const int *block_ids, int num_blocks, const int *terminal_ids, int num_terminals)
+{
+    if(indexed){
+        cerr<<"Nets have to be added before floorplanning\n";
+        exit(1);
+    }
+    vector<int> blocks(block_ids, block_ids+num_blocks);
+    vector<int> terminals(terminal_ids, terminal_ids+num_terminals);
+    for(int id : blocks){
+        if(id<0 || id>=(int)fp->block_list.size()){
+            cerr<<"Net pin of unknown block "<<id<<"\n";
+            exit(1);
+        }
+    }
+    for(int id : terminals){
+        if(id<0 || id>=(int)fp->terminal_list.size()){
+            cerr<<"Net pin of unknown terminal "<<id<<"\n";
+            exit(1);
+        }
+    }
+    fp->add_net(blocks, terminals);
+}
+
+void FloorplanInstance::set_time_limit(double sec)
+{
+    fp->set_time_limit(sec);
+}
+
+void FloorplanInstance::set_seed(unsigned seed)
+{
+    fp->set_seed(seed);
+}
+
+void FloorplanInstance::set_verbose(bool val)
+{
+    fp->verbose = val;
+}
+
+bool FloorplanInstance::floorplan()
+{
+    if(!indexed){
+        fp->index_design();
+        indexed = true;
+    }
+    if(fp->num_blocks==0) return true;
+    fp->floorplan();
+    return fp->is_legal();
+}
+
+void FloorplanInstance::get_block(int id, int &x, int &y, int &width, int &height) const
+{
+    if(id<0 || id>=(int)fp->block_list.size()){
+        cerr<<"Unknown block "<<id<<"\n";
+        exit(1);
+    }
+    const Block *block = fp->block_list[id];
+    x = block->get_x();
+    y = block->get_y();
+    width = block->get_width();
+    height = block->get_height();
+}
+
+int FloorplanInstance::get_chip_width() const
+{
+    return fp->get_chip_width();
+}
+
+int FloorplanInstance::get_chip_height() const
+{
+    return fp->get_chip_height();
+}
+
+double FloorplanInstance::get_wirelength() const
+{
+    return fp->get_wl();
+}
@@ -0,0 +1,40 @@
+#ifndef FPLIB_H
+#define FPLIB_H
+
+// Library interface of the floorplanner, built as lib/libfp.a by make lib.
+// Designs are built in memory instead of parsed from .block and .nets files.
+// Only plain types cross this interface so that programs built for another
+// standard library ABI, such as the placer of PA3, can link the library.
+
+class Floorplanner;
+
+// floorplanner of hard blocks within a fixed outline with lower-left corner at (0,0),
+// connected by nets among blocks and fixed terminals
+class FloorplanInstance
+{
+    Floorplanner *fp;
+    bool indexed; // the net index is built once before floorplanning
+    FloorplanInstance(const FloorplanInstance&);
+    FloorplanInstance& operator=(const FloorplanInstance&);
+public:
+    // cost is alpha*area + (1-alpha)*wirelength as for bin/fp
+    FloorplanInstance(int outline_width, int outline_height, double alpha);
+    ~FloorplanInstance();
+    // design construction, ids are given in order from 0
+    int add_block(int width, int height);
+    int add_terminal(int x, int y);
+    void add_net(const int *block_ids, int num_blocks, const int *terminal_ids, int num_terminals);
+    // options, the time limit counts from construction of the instance
+    void set_time_limit(double sec);
+    void set_seed(unsigned seed);
+    void set_verbose(bool val);
+    // returns whether the floorplan fits in the outline
+    bool floorplan();
+    // lower-left corner and dimension of a block, swapped if the block is rotated
+    void get_block(int id, int &x, int &y, int &width, int &height) const;
+    int get_chip_width() const;
+    int get_chip_height() const;
+    double get_wirelength() const;
+};
+
+#endif
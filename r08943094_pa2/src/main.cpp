@@ -2,6 +2,7 @@
 #include <fstream>
 #include <vector>
 #include <cstring>
+#include <sstream>
 #include "floorplanner.h"
 using namespace std;
 
@@ -10,12 +11,26 @@ int main(int argc, char** argv)
     fstream block_file, net_file, output_file;
     bool gui_flag = false;
     string plot_name = "plot.png";
+    int num_replicas = 1;
+    int num_speculations = 1;
+    int num_sample_threads = 1;
+    bool fast_schedule = true;
+    int plateau_window = 50;
+    double time_limit = 0.;
+    string engine = "bstree";
+    int num_clusters = 0;
+    int cache_size = 4096;
+    unsigned seed = 0;
+    bool check_flag = false;
+    string trace_prefix;
+    string checkpoint_name, resume_name;
+    double checkpoint_interval = 5.;
+    vector<double> alphas;
     cout<<fixed;
 
     if (argc >= 5) {
         block_file.open(argv[2], ios::in);
         net_file.open(argv[3], ios::in);
-        output_file.open(argv[4], ios::out);
         if (!block_file) {
             cerr << "Cannot open the .block file \"" << argv[2]
                  << "\". The program will be terminated..." << endl;
@@ -26,29 +41,168 @@ int main(int argc, char** argv)
                  << "\". The program will be terminated..." << endl;
             exit(1);
         }
+        for(int i = 5; i<argc; i++){
+            if(argv[i]==string("-gui")){
+                gui_flag = true;
+                cout<<"Plot result will be saved\n";
+                if(i+1<argc && argv[i+1][0]!='-'){
+                    plot_name = argv[++i];
+                }
+            }
+            else if(argv[i]==string("--pt") && i+1<argc){
+                num_replicas = stoi(argv[++i]);
+            }
+            else if(argv[i]==string("--spec") && i+1<argc){
+                num_speculations = stoi(argv[++i]);
+            }
+            else if(argv[i]==string("--sample-threads") && i+1<argc){
+                num_sample_threads = stoi(argv[++i]);
+            }
+            else if(argv[i]==string("--schedule") && i+1<argc){
+                string schedule = argv[++i];
+                if(schedule!="fast" && schedule!="geometric"){
+                    cerr << "Unknown cooling schedule \"" << schedule << "\"" << endl;
+                    exit(1);
+                }
+                fast_schedule = schedule=="fast";
+            }
+            else if(argv[i]==string("--plateau") && i+1<argc){
+                plateau_window = stoi(argv[++i]);
+            }
+            else if(argv[i]==string("--time-limit") && i+1<argc){
+                time_limit = stod(argv[++i]);
+            }
+            else if(argv[i]==string("--engine") && i+1<argc){
+                engine = argv[++i];
+            }
+            else if(argv[i]==string("--cluster") && i+1<argc){
+                num_clusters = stoi(argv[++i]);
+            }
+            else if(argv[i]==string("--seed") && i+1<argc){
+                seed = stoul(argv[++i]);
+            }
+            else if(argv[i]==string("--cache") && i+1<argc){
+                cache_size = stoi(argv[++i]);
+            }
+            else if(argv[i]==string("--alpha-sweep") && i+1<argc){
+                stringstream ss(argv[++i]);
+                string token;
+                while(getline(ss, token, ',')) alphas.push_back(stod(token));
+            }
+            else if(argv[i]==string("--trace") && i+1<argc){
+                trace_prefix = argv[++i];
+            }
+            else if(argv[i]==string("--checkpoint") && i+1<argc){
+                checkpoint_name = argv[++i];
+            }
+            else if(argv[i]==string("--checkpoint-interval") && i+1<argc){
+                checkpoint_interval = stod(argv[++i]);
+            }
+            else if(argv[i]==string("--resume") && i+1<argc){
+                resume_name = argv[++i];
+            }
+            else if(argv[i]==string("--check")){
+                check_flag = true;
+            }
+            else{
+                cerr << "Unknown option \"" << argv[i] << "\"" << endl;
+                exit(1);
+            }
+        }
+        if (!trace_prefix.empty() && !alphas.empty()) {
+            cerr << "--trace cannot be combined with --alpha-sweep" << endl;
+            exit(1);
+        }
+        if ((!checkpoint_name.empty() || !resume_name.empty()) && (num_replicas > 1 || num_clusters > 0 || !alphas.empty())) {
+            cerr << "--checkpoint and --resume only apply to SA, not to --pt, --cluster or --alpha-sweep" << endl;
+            exit(1);
+        }
+        // an existing result is read back for validation
+        output_file.open(argv[4], check_flag ? ios::in : ios::out);
         if (!output_file) {
             cerr << "Cannot open the output file \"" << argv[4]
                  << "\". The program will be terminated..." << endl;
             exit(1);
         }
-        if(argc >= 6 && argv[5]==string("-gui")){
-            gui_flag = true;
-            cout<<"Plot result will be saved\n";
-            if(argc>=7){
-                plot_name = argv[6];
-            }
-        }
     }
     else {
-        cerr << "Usage: ./fp <α value> <input.block name> <input.net name> <output file name> [-gui [plot_name.png]]" << endl;
+        cerr << "Usage: ./fp <α value> <input.block name> <input.net name> <output file name> [-gui [plot_name.png]] [--pt <num replicas>] [--spec <num threads>]"
+             << " [--sample-threads <num threads>]"
+             << " [--schedule fast|geometric] [--plateau <num temperatures>] [--time-limit <sec>]"
+             << " [--engine bstree|seqpair] [--cluster <num clusters>] [--cache <num entries>] [--seed <seed>] [--check]"
+             << " [--alpha-sweep <α1,α2,...>] [--trace <prefix>]"
+             << " [--checkpoint <file> [--checkpoint-interval <sec>]] [--resume <file>]" << endl;
         exit(1);
     }
 
     Floorplanner* floorplanner = new Floorplanner();
     floorplanner->set_alpha(stod(argv[1]));
+    floorplanner->set_engine(engine);
+    floorplanner->set_num_replicas(num_replicas);
+    floorplanner->set_num_speculations(num_speculations);
+    floorplanner->set_num_sample_threads(num_sample_threads);
+    floorplanner->set_num_clusters(num_clusters);
+    floorplanner->set_cache_size(cache_size);
+    floorplanner->set_seed(seed);
+    floorplanner->set_fast_schedule(fast_schedule);
+    floorplanner->set_plateau_window(plateau_window);
+    floorplanner->set_time_limit(time_limit);
     floorplanner->parse_block(block_file);
     floorplanner->parse_net(net_file);
+    if(check_flag){
+        bool valid = floorplanner->check_result(output_file);
+        cout<<"Result "<<argv[4]<<(valid ? " is valid" : " is invalid")<<endl;
+        return valid ? 0 : 1;
+    }
+    if(!checkpoint_name.empty()) floorplanner->set_checkpoint(checkpoint_name, checkpoint_interval);
+    if(!resume_name.empty()){
+        fstream checkpoint_file(resume_name, ios::in);
+        if (!checkpoint_file) {
+            cerr << "Cannot open the checkpoint file \"" << resume_name << "\". The program will be terminated..." << endl;
+            exit(1);
+        }
+        floorplanner->resume(checkpoint_file);
+    }
+    if(!alphas.empty()){
+        // one result per alpha next to the output file, which gets the pareto summary
+        vector<Floorplanner*> results = floorplanner->sweep_alpha(alphas);
+        string output_name = argv[4];
+        size_t dot = output_name.rfind('.');
+        if(dot==string::npos || dot<output_name.rfind('/')+1) dot = output_name.size();
+        for(Floorplanner *result : results){
+            stringstream name;
+            name<<output_name.substr(0, dot)<<"_a"<<result->get_alpha()<<output_name.substr(dot);
+            fstream result_file(name.str(), ios::out);
+            if(!result_file){
+                cerr<<"Cannot open the output file \""<<name.str()<<"\". The program will be terminated..."<<endl;
+                exit(1);
+            }
+            result->write_result(result_file);
+            cout<<"Alpha "<<result->get_alpha()<<": ";
+            result->print_summary(0);
+        }
+        Floorplanner::write_pareto(output_file, results);
+        return 0;
+    }
+    // per-temperature statistics go to <prefix>.csv and the phase profile to <prefix>.json
+    fstream trace_file;
+    if(!trace_prefix.empty()){
+        trace_file.open(trace_prefix+".csv", ios::out);
+        if (!trace_file) {
+            cerr << "Cannot open the trace file \"" << trace_prefix << ".csv\". The program will be terminated..." << endl;
+            exit(1);
+        }
+        floorplanner->set_trace(&trace_file);
+    }
     floorplanner->floorplan();
+    if(!trace_prefix.empty()){
+        fstream profile_file(trace_prefix+".json", ios::out);
+        if (!profile_file) {
+            cerr << "Cannot open the trace file \"" << trace_prefix << ".json\". The program will be terminated..." << endl;
+            exit(1);
+        }
+        floorplanner->write_profile(profile_file);
+    }
     if(gui_flag) floorplanner->plot(plot_name);
     floorplanner->print_summary(1);
     floorplanner->write_result(output_file);
@@ -9,8 +9,6 @@ using namespace std;
 typedef pair<int, int> XY;
 typedef pair<double, double> CenterXY;
 
-struct Node;
-
 class Terminal
 {
     int _id;
@@ -36,9 +34,8 @@ public:
     }
 };
 
-class Block : public Terminal
+class Block final : public Terminal
 {
-    Node *_node;
     int _width;
     int _height;
 public:
@@ -48,15 +45,12 @@ public:
     _height(min(w,h))
     {}
     // getter
-    Node* get_node() const{return _node;}
     int get_width() const{return _width;}
     int get_height() const{return _height;}
     bool get_orien() const{return _width < _height;}
     XY get_low_xy() const{return XY(get_x(), get_y());}
     XY get_top_xy() const{return XY(get_x()+_width, get_y()+_height);}
     CenterXY get_center_xy() const{return CenterXY((double)get_x()+(double)_width/2.0,(double)get_y()+(double)_height/2.0);}
-    // setter
-    void set_node(Node *node){_node = node;}
     // method
     void rotate(){int tmp = _width; _width = _height; _height = tmp;}
     void print(){
@@ -79,28 +73,3 @@ public:
     int get_id() const{return _id;}
     const vector<Terminal*>& get_terminals() const{return _terminals;}
 };
-
-struct Node
-{
-    int id; // the same as block id
-    bool orien; // orientation, 0 for larger width, 1 for larger height
-    Node *left;
-    Node *right;
-    Node *parent;
-    Node(Block *block):
-    id(block->get_id()),
-    orien(block->get_orien()),
-    left(nullptr),
-    right(nullptr),
-    parent(nullptr)
-    {
-        block->set_node(this);
-    }
-    Node(Node *node):
-    id(node->id),
-    orien(node->orien),
-    left(nullptr),
-    right(nullptr),
-    parent(nullptr)
-    {}
-};
@@ -0,0 +1,58 @@
+#include "profiler.h"
+
+using namespace std;
+
+static const char *phase_names[NUM_PHASES] = {"operation", "pack", "wirelength", "copy", "accept"};
+
+void Profiler::reset()
+{
+    num_placed = 0;
+    for(int p = 0; p<NUM_PHASES; p++){
+        counts[p] = 0;
+        total_time[p] = 0.;
+        for(int b = 0; b<NUM_BUCKETS; b++) histograms[p][b] = 0;
+    }
+}
+
+void Profiler::stop(Phase phase, TimePoint start_time)
+{
+    if(!enabled) return;
+    long long ns = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start_time).count();
+    counts[phase]++;
+    total_time[phase] += ns * 1e-9;
+    // bucket b holds durations in [2^b, 2^(b+1)) ns
+    int bucket = 0;
+    while(bucket+1 < NUM_BUCKETS && ns >> (bucket+1)) bucket++;
+    histograms[phase][bucket]++;
+}
+
+// placed is the number of placements by the engine of the merged profiler
+void Profiler::merge(const Profiler &profiler, long long placed)
+{
+    num_placed += profiler.num_placed + placed;
+    for(int p = 0; p<NUM_PHASES; p++){
+        counts[p] += profiler.counts[p];
+        total_time[p] += profiler.total_time[p];
+        for(int b = 0; b<NUM_BUCKETS; b++) histograms[p][b] += profiler.histograms[p][b];
+    }
+}
+
+// one object per phase, histogram entries are counts of power-of-two nanosecond buckets
+void Profiler::write_json(ostream &output) const
+{
+    output<<"{";
+    for(int p = 0; p<NUM_PHASES; p++){
+        // trailing empty buckets are left out
+        int num_buckets = NUM_BUCKETS;
+        while(num_buckets > 0 && histograms[p][num_buckets-1]==0) num_buckets--;
+        output<<(p ? ",\n    " : "\n    ")<<"\""<<phase_names[p]<<"\": {\"count\": "<<counts[p]
+              <<", \"total_sec\": "<<total_time[p]
+              <<", \"mean_us\": "<<(counts[p] ? total_time[p]/counts[p]*1e6 : 0.)
+              <<", \"histogram_log2_ns\": [";
+        for(int b = 0; b<num_buckets; b++){
+            output<<(b ? ", " : "")<<histograms[p][b];
+        }
+        output<<"]}";
+    }
+    output<<"\n  }";
+}
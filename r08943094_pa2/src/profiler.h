@@ -0,0 +1,44 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <ostream>
+
+using namespace std;
+
+enum Phase
+{
+    PHASE_OPERATION, // random operation on the representation
+    PHASE_PACK,
+    PHASE_WIRELENGTH,
+    PHASE_COPY, // representation copy for backup and restore
+    PHASE_ACCEPT, // acceptance decision and undo
+    NUM_PHASES
+};
+
+// wall time spent in floorplanner phases, with histograms of single durations
+// in power-of-two buckets of nanoseconds, disabled unless tracing
+class Profiler
+{
+    static const int NUM_BUCKETS = 32;
+    bool enabled;
+    long long counts[NUM_PHASES];
+    double total_time[NUM_PHASES]; // in seconds
+    long long histograms[NUM_PHASES][NUM_BUCKETS];
+    long long num_placed; // engine placements of merged profilers
+public:
+    typedef chrono::steady_clock::time_point TimePoint;
+    Profiler() : enabled(false) {reset();}
+    void reset();
+    void set_enabled(bool val){enabled = val;}
+    bool is_enabled() const{return enabled;}
+    // start of a phase, the clock is only read when enabled
+    TimePoint start() const{return enabled ? chrono::steady_clock::now() : TimePoint();}
+    void stop(Phase phase, TimePoint start_time);
+    long long get_count(Phase phase) const{return counts[phase];}
+    long long get_num_placed() const{return num_placed;}
+    void merge(const Profiler &profiler, long long placed);
+    void write_json(ostream &output) const;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// xoshiro256** generator: four words of state, a few shifts and multiplies per sample
+// jump() advances by 2^128 samples, so jumped copies are non-overlapping streams for threads
+class Xoshiro256
+{
+    uint64_t s[4];
+    static uint64_t rotl(uint64_t x, int k){return (x << k) | (x >> (64 - k));}
+public:
+    typedef uint64_t result_type;
+    explicit Xoshiro256(uint64_t val=0){seed(val);}
+    // state from splitmix64 of the seed, never all zero
+    void seed(uint64_t val){
+        for(int i = 0; i<4; i++){
+            uint64_t z = (val += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            s[i] = z ^ (z >> 31);
+        }
+    }
+    uint64_t operator()(){
+        uint64_t result = rotl(s[1] * 5, 7) * 9;
+        uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+    static constexpr uint64_t min(){return 0;}
+    static constexpr uint64_t max(){return UINT64_MAX;}
+    // uniform in [0,1) from the top 53 bits
+    double uniform(){return (double)((*this)() >> 11) * (1. / 9007199254740992.);}
+    // uniform integer in [0,n) by multiplying the top 32 bits, biased by at most n/2^32
+    int below(int n){return (int)((((*this)() >> 32) * (uint64_t)n) >> 32);}
+    void jump(){
+        static const uint64_t JUMP[4] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+        uint64_t t[4] = {0, 0, 0, 0};
+        for(int i = 0; i<4; i++){
+            for(int b = 0; b<64; b++){
+                if(JUMP[i] & (1ULL << b)){
+                    for(int k = 0; k<4; k++) t[k] ^= s[k];
+                }
+                (*this)();
+            }
+        }
+        for(int k = 0; k<4; k++) s[k] = t[k];
+    }
+    friend ostream& operator<<(ostream &output, const Xoshiro256 &rng){
+        return output<<rng.s[0]<<" "<<rng.s[1]<<" "<<rng.s[2]<<" "<<rng.s[3];
+    }
+    friend istream& operator>>(istream &input, Xoshiro256 &rng){
+        return input>>rng.s[0]>>rng.s[1]>>rng.s[2]>>rng.s[3];
+    }
+};
+
+// minstd generator of the standard library behind the same interface, selected by make RNG=std
+class StdRandom
+{
+    default_random_engine engine;
+    uniform_real_distribution<double> unif;
+public:
+    typedef default_random_engine::result_type result_type;
+    explicit StdRandom(uint64_t val=0) : engine(val), unif(0., 1.) {}
+    void seed(uint64_t val){engine.seed(val);}
+    result_type operator()(){return engine();}
+    static constexpr result_type min(){return default_random_engine::min();}
+    static constexpr result_type max(){return default_random_engine::max();}
+    double uniform(){return unif(engine);}
+    int below(int n){return std::min(n-1, (int)(uniform()*n));}
+    // streams are only decorrelated by discarding samples
+    void jump(){engine.discard(1000003);}
+    friend ostream& operator<<(ostream &output, const StdRandom &rng){return output<<rng.engine;}
+    // the engine does not skip whitespace by itself
+    friend istream& operator>>(istream &input, StdRandom &rng){return input>>ws>>rng.engine;}
+};
+
+#ifdef STD_RANDOM
+typedef StdRandom RandomEngine;
+#else
+typedef Xoshiro256 RandomEngine;
+#endif
+
+// -ln(u) of a uniform u in (0,1], interpolated in a table shared by all temperatures,
+// ln is only computed for u < 1/64, where the curve is too steep to interpolate
+// the interpolation error is below 3e-5
+inline double fast_neg_log(double u)
+{
+    static const int SIZE = 4096;
+    // -ln(i/SIZE), the extra entry interpolates up to u = 1
+    static const vector<double> table = []{
+        vector<double> values(SIZE+2, 0.);
+        for(int i = SIZE/64; i<=SIZE+1; i++) values[i] = -log((double)i/SIZE);
+        return values;
+    }();
+    if(u < 1./64) return -log(u);
+    double x = u*SIZE;
+    int i = x;
+    return table[i] + (x-i)*(table[i+1]-table[i]);
+}
+
+#endif
@@ -0,0 +1,59 @@
+#include "threadpool.h"
+
+using namespace std;
+
+ThreadPool::ThreadPool(int num_threads):
+num_tasks(0),
+next_task(0),
+num_done(0),
+generation(0),
+stop(false)
+{
+    for(int i = 0; i<num_threads; i++){
+        workers.emplace_back(&ThreadPool::worker_loop, this);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        stop = true;
+    }
+    cv_task.notify_all();
+    for(thread &worker : workers){
+        worker.join();
+    }
+}
+
+void ThreadPool::run(int n, const function<void(int)> &fn)
+{
+    if(n<=0) return;
+    unique_lock<mutex> lock(mtx);
+    task = fn;
+    num_tasks = n;
+    next_task = 0;
+    num_done = 0;
+    generation++;
+    cv_task.notify_all();
+    cv_done.wait(lock, [this]{return num_done==num_tasks;});
+}
+
+void ThreadPool::worker_loop()
+{
+    long seen = 0;
+    unique_lock<mutex> lock(mtx);
+    while(true){
+        cv_task.wait(lock, [this, seen]{return stop || generation!=seen;});
+        if(stop) return;
+        seen = generation;
+        // take tasks of the current batch until none left
+        while(next_task < num_tasks){
+            int idx = next_task++;
+            lock.unlock();
+            task(idx);
+            lock.lock();
+            if(++num_done==num_tasks) cv_done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+// persistent worker threads running batches of indexed tasks
+class ThreadPool
+{
+    vector<thread> workers;
+    mutex mtx;
+    condition_variable cv_task;
+    condition_variable cv_done;
+    function<void(int)> task;
+    int num_tasks;
+    int next_task;
+    int num_done;
+    long generation; // incremented for every batch
+    bool stop;
+    void worker_loop();
+public:
+    ThreadPool(int num_threads);
+    ~ThreadPool();
+    int get_num_threads() const{return workers.size();}
+    // run task(0) ... task(n-1) on the workers and wait for all of them
+    void run(int n, const function<void(int)> &fn);
+};
+
+#endif
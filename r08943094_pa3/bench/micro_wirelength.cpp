@@ -0,0 +1,127 @@
+#define _GLIBCXX_USE_CXX11_ABI 0
+#include "../src/Placement.h"
+#include "../src/WirelengthModel.h"
+#include "../src/arghandler.h"
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+
+using namespace std;
+
+// previous ExampleFunction::total_wirelength(): lse() takes the pin vector by value and runs
+// inside the pin loop, so a net of p pins costs O(p^2) exp() calls and p*4 vector copies
+static double lse(vector<double> vals, double scale, double gamma)
+{
+    double lse = 0.;
+    for(size_t i = 0; i<vals.size(); i++){
+        lse += exp(scale*vals[i]/gamma);
+    }
+    return log(lse);
+}
+
+static double legacy_wirelength(const vector<int> &net_start, const vector<int> &pin_module, const vector<double> &x, double gamma)
+{
+    double total_wl = 0.;
+    for(size_t n = 0; n+1<net_start.size(); n++){
+        int num_pins = net_start[n+1] - net_start[n];
+        vector<double> xs(num_pins, 0.);
+        vector<double> ys(num_pins, 0.);
+        for(int p = 0; p<num_pins; p++){
+            int m_id = pin_module[net_start[n]+p];
+            xs[p] = x[2*m_id];
+            ys[p] = x[2*m_id+1];
+            total_wl += lse(xs, 1, gamma) + lse(xs, -1, gamma) + lse(ys, 1, gamma) + lse(ys, -1, gamma);
+        }
+    }
+    return gamma * total_wl;
+}
+
+// LSE wirelength summed per net without the max shift, as the model defines it
+static double reference_lse(const vector<int> &net_start, const vector<int> &pin_module, const vector<double> &x, double gamma)
+{
+    double total_wl = 0.;
+    for(size_t n = 0; n+1<net_start.size(); n++){
+        for(int dim = 0; dim<2; dim++){
+            double sum_max = 0., sum_min = 0.;
+            for(int k = net_start[n]; k<net_start[n+1]; k++){
+                sum_max += exp(x[2*pin_module[k]+dim]/gamma);
+                sum_min += exp(-x[2*pin_module[k]+dim]/gamma);
+            }
+            if(net_start[n+1] - net_start[n] >= 2) total_wl += gamma*(log(sum_max) + log(sum_min));
+        }
+    }
+    return total_wl;
+}
+
+// evaluations per second of fn, run for about a second
+template<typename Fn>
+void measure(const char *name, Fn fn)
+{
+    int num_evals = 0;
+    double sum = 0.;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double elapsed = 0.;
+    while(elapsed < 1.){
+        sum += fn();
+        num_evals++;
+        elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    printf("  %-28s %10.1f evals/sec (value %.6e)\n", name, num_evals/elapsed, sum/num_evals);
+}
+
+static void run(const char *name, const vector<int> &net_start, const vector<int> &pin_module, int num_modules, double chip_size)
+{
+    double gamma = chip_size / log(10.); // as ExampleFunction
+    srand(0);
+    vector<double> x(2*num_modules);
+    for(size_t i = 0; i<x.size(); i++) x[i] = chip_size * rand() / RAND_MAX;
+    vector<double> g(x.size());
+    WirelengthModel lse_model(net_start, pin_module, num_modules, WirelengthModel::LSE, gamma);
+    WirelengthModel wa_model(net_start, pin_module, num_modules, WirelengthModel::WA, gamma);
+
+    printf("%s: %d modules, %d nets, %d pins\n", name, num_modules, (int)net_start.size()-1, (int)pin_module.size());
+    double ref = reference_lse(net_start, pin_module, x, gamma);
+    double val = lse_model.evaluate(x, NULL);
+    printf("  LSE relative error to the unshifted sum: %.3e\n", fabs(val - ref) / ref);
+    measure("legacy total_wirelength", [&]{return legacy_wirelength(net_start, pin_module, x, gamma);});
+    measure("LSE value", [&]{return lse_model.evaluate(x, NULL);});
+    measure("LSE value and gradient", [&]{g.assign(g.size(), 0.); return lse_model.evaluate(x, &g);});
+    measure("WA value", [&]{return wa_model.evaluate(x, NULL);});
+    measure("WA value and gradient", [&]{g.assign(g.size(), 0.); return wa_model.evaluate(x, &g);});
+}
+
+// Wirelength evaluations per second of the legacy loop and the LSE and WA kernels on the
+// bookshelf benchmarks given as arguments (e.g. benchmark/ibm01/ibm01-cu85.aux ...), or on a
+// random netlist of ibm01 size without arguments. Module centers are random within the chip.
+int main(int argc, char *argv[])
+{
+    gArg.Init(argc, argv);
+    if(argc < 2){
+        // degrees 2 to 5 mostly, with a few large nets
+        int num_modules = 12752, num_nets = 14111;
+        srand(1);
+        vector<int> net_start(1, 0), pin_module;
+        for(int n = 0; n<num_nets; n++){
+            int degree = rand()%100 < 97 ? 2 + rand()%4 : 6 + rand()%40;
+            for(int k = 0; k<degree; k++) pin_module.push_back(rand()%num_modules);
+            net_start.push_back(pin_module.size());
+        }
+        run("random", net_start, pin_module, num_modules, 1e4);
+        return 0;
+    }
+    for(int i = 1; i<argc; i++){
+        Placement placement;
+        placement.readBookshelfFormat(argv[i], "");
+        vector<int> net_start(1, 0), pin_module;
+        for(unsigned n = 0; n<placement.numNets(); n++){
+            Net &net = placement.net(n);
+            for(unsigned p = 0; p<net.numPins(); p++) pin_module.push_back(net.pin(p).moduleId());
+            net_start.push_back(pin_module.size());
+        }
+        Rectangle chip = placement.rectangleChip();
+        run(placement.name().c_str(), net_start, pin_module, placement.numModules(), max(chip.width(), chip.height()));
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "DCT.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+
+DCT::DCT(int n)
+    : _n(n), _twiddle(n/2), _shift(n), _bit_reverse(n), _buffer(n), _output(n), _line(n)
+{
+    if(n < 1 || (n & (n-1))){
+        cerr<<"DCT length has to be a power of two\n";
+        exit(1);
+    }
+    for(int k = 0; k<n/2; k++){
+        _twiddle[k] = polar(1., -2.*M_PI*k/n);
+    }
+    for(int u = 0; u<n; u++){
+        _shift[u] = polar(1., -M_PI*u/(2.*n));
+    }
+    int bits = 0;
+    while((1<<bits) < n) bits++;
+    for(int k = 0; k<n; k++){
+        int r = 0;
+        for(int b = 0; b<bits; b++){
+            if(k & (1<<b)) r |= 1<<(bits-1-b);
+        }
+        _bit_reverse[k] = r;
+    }
+}
+
+// iterative radix-2 FFT of _buffer in place, unnormalized, with exp(+2*pi*i*u*k/n) if inverse
+void DCT::fft(bool inverse)
+{
+    for(int k = 0; k<_n; k++){
+        if(k < _bit_reverse[k]) swap(_buffer[k], _buffer[_bit_reverse[k]]);
+    }
+    for(int len = 2; len<=_n; len <<= 1){
+        int step = _n/len;
+        for(int i = 0; i<_n; i += len){
+            for(int k = 0; k<len/2; k++){
+                complex<double> w = inverse ? conj(_twiddle[k*step]) : _twiddle[k*step];
+                complex<double> a = _buffer[i+k];
+                complex<double> b = _buffer[i+k+len/2]*w;
+                _buffer[i+k] = a + b;
+                _buffer[i+k+len/2] = a - b;
+            }
+        }
+    }
+}
+
+// Makhoul: even samples in order followed by odd samples in reverse, then
+// X[u] = Re(exp(-i*pi*u/(2n)) * FFT[u])
+void DCT::dct(double *data)
+{
+    for(int k = 0; k<_n/2; k++){
+        _buffer[k] = data[2*k];
+        _buffer[_n-1-k] = data[2*k+1];
+    }
+    if(_n == 1) _buffer[0] = data[0];
+    fft(false);
+    for(int u = 0; u<_n; u++){
+        data[u] = (_shift[u]*_buffer[u]).real();
+    }
+}
+
+// the inverse of dct scaled by n/2 with b[0] weighted twice
+void DCT::idct(double *data)
+{
+    for(int u = 0; u<_n; u++){
+        double re = u == 0 ? 2.*data[0] : data[u];
+        double im = u == 0 ? 0. : -data[_n-u];
+        _buffer[u] = conj(_shift[u])*complex<double>(re, im);
+    }
+    fft(true);
+    for(int k = 0; k<_n/2; k++){
+        _output[2*k] = _buffer[k].real()/2.;
+        _output[2*k+1] = _buffer[_n-1-k].real()/2.;
+    }
+    if(_n == 1) _output[0] = _buffer[0].real()/2.;
+    for(int k = 0; k<_n; k++) data[k] = _output[k];
+}
+
+// sin(pi*u*(2k+1)/(2n)) = (-1)^k cos(pi*(n-u)*(2k+1)/(2n)), so the sine series is the
+// cosine series of the reversed coefficients with alternating signs
+void DCT::idxst(double *data)
+{
+    for(int u = 0; u<_n/2; u++){
+        swap(data[u], data[_n-1-u]);
+    }
+    // data[v] now holds b[n-1-v], shift to b'[u] = b[n-u]
+    for(int u = _n-1; u>0; u--) data[u] = data[u-1];
+    data[0] = 0.;
+    idct(data);
+    for(int k = 1; k<_n; k += 2) data[k] = -data[k];
+}
+
+void DCT::transform(double *data, int type)
+{
+    if(type == 0) dct(data);
+    else if(type == 1) idct(data);
+    else idxst(data);
+}
+
+void DCT::transformLines(vector<double> &grid, bool columns, int type, ThreadPool *pool)
+{
+    const int LINES = 16; // lines per task
+    int num_chunks = (_n + LINES-1) / LINES;
+    if((int)_lanes.size() < num_chunks) _lanes.resize(num_chunks, DCT(_n));
+    parallelRun(pool, num_chunks, [&](int c){
+        DCT &lane = _lanes[c];
+        for(int i = c*LINES; i<min((c+1)*LINES, _n); i++){
+            if(!columns){
+                lane.transform(&grid[i*_n], type);
+                continue;
+            }
+            for(int r = 0; r<_n; r++) lane._line[r] = grid[r*_n+i];
+            lane.transform(&lane._line[0], type);
+            for(int r = 0; r<_n; r++) grid[r*_n+i] = lane._line[r];
+        }
+    });
+}
+
+void DCT::dct2(vector<double> &grid, ThreadPool *pool)
+{
+    transformLines(grid, false, 0, pool);
+    transformLines(grid, true, 0, pool);
+}
+
+void DCT::idct2(vector<double> &grid, bool sine_x, bool sine_y, ThreadPool *pool)
+{
+    transformLines(grid, false, sine_x ? 2 : 1, pool);
+    transformLines(grid, true, sine_y ? 2 : 1, pool);
+}
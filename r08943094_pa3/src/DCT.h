@@ -0,0 +1,45 @@
+#define _GLIBCXX_USE_CXX11_ABI 0
+#ifndef DCT_H
+#define DCT_H
+
+#include <vector>
+#include <complex>
+#include "Parallel.h"
+
+using namespace std;
+
+// Cosine and sine transforms of length n (a power of two) through an n-point complex FFT.
+// For a sequence x and coefficients b:
+//   dct:   X[u] = sum_k x[k] cos(pi*u*(2k+1)/(2n))
+//   idct:  y[k] = sum_u b[u] cos(pi*u*(2k+1)/(2n))
+//   idxst: y[k] = sum_u b[u] sin(pi*u*(2k+1)/(2n))
+// 2D versions transform the rows and then the columns of an n x n row-major grid, in chunks
+// of lines on the thread pool if one is given.
+class DCT
+{
+public:
+    DCT(int n = 1);
+    int size() const {return _n;}
+    void dct(double *data);
+    void idct(double *data);
+    void idxst(double *data);
+    // idct or idxst along x (within rows) and along y (within columns)
+    void dct2(vector<double> &grid, ThreadPool *pool = NULL);
+    void idct2(vector<double> &grid, bool sine_x = false, bool sine_y = false, ThreadPool *pool = NULL);
+
+private:
+    int _n;
+    vector<complex<double> > _twiddle; // exp(-2*pi*i*k/n), k < n/2
+    vector<complex<double> > _shift; // exp(-i*pi*u/(2n))
+    vector<int> _bit_reverse;
+    vector<complex<double> > _buffer;
+    vector<double> _output; // idct result before it is copied back
+    vector<double> _line; // column of a grid
+    vector<DCT> _lanes; // transforms of the chunks of lines of 2D transforms
+    void fft(bool inverse);
+    // transform of type 0 (dct), 1 (idct) or 2 (idxst) of every row, or every column
+    void transformLines(vector<double> &grid, bool columns, int type, ThreadPool *pool);
+    void transform(double *data, int type);
+};
+
+#endif // DCT_H
@@ -0,0 +1,207 @@
+#include "ElectrostaticDensity.h"
+#include <cmath>
+#include <algorithm>
+
+// bin rows and modules per parallel task, fixed so that sums are taken in the same order
+static const int BAND_ROWS = 8;
+static const int MODULE_CHUNK = 4096;
+
+ElectrostaticDensity::ElectrostaticDensity(Placement &placement, int bin_res, double target_density)
+    : _chip(placement.rectangleChip()), _n(1), _target_density(target_density), _movable_area(0.), _overflow(0.), _pool(NULL)
+{
+    while(_n < bin_res) _n <<= 1;
+    _bin_width = _chip.width() / _n;
+    _bin_height = _chip.height() / _n;
+    _dct = DCT(_n);
+    _freq.resize(_n);
+    for(int u = 0; u<_n; u++) _freq[u] = M_PI*u/_n;
+    _fixed_area.assign(_n*_n, 0.);
+    _area.resize(_n*_n);
+    _potential.resize(_n*_n);
+    _field_x.resize(_n*_n);
+    _field_y.resize(_n*_n);
+    _band_sum.resize((_n + BAND_ROWS-1) / BAND_ROWS);
+
+    int num_modules = placement.numModules();
+    _movable.resize(num_modules);
+    _width.resize(num_modules);
+    _height.resize(num_modules);
+    _scale.resize(num_modules);
+    for(int m = 0; m<num_modules; m++){
+        Module &module = placement.module(m);
+        _movable[m] = !module.isFixed();
+        if(_movable[m]){
+            _movable_area += module.width()*module.height();
+            // local smoothing of ePlace, a module covers at least sqrt(2) bins in each direction
+            _width[m] = max(module.width(), sqrt(2.)*_bin_width);
+            _height[m] = max(module.height(), sqrt(2.)*_bin_height);
+            _scale[m] = module.width()*module.height() / (_width[m]*_height[m]);
+            continue;
+        }
+        // fixed modules are charges where they are, clipped to the chip
+        _width[m] = module.width();
+        _height[m] = module.height();
+        _scale[m] = 1.;
+        double x1 = max(module.x(), _chip.left()), x2 = min(module.x()+module.width(), _chip.right());
+        double y1 = max(module.y(), _chip.bottom()), y2 = min(module.y()+module.height(), _chip.top());
+        if(x1 >= x2 || y1 >= y2) continue;
+        int c1, c2, r1, r2;
+        binRange(x1, x2, _chip.left(), _bin_width, c1, c2);
+        binRange(y1, y2, _chip.bottom(), _bin_height, r1, r2);
+        for(int r = r1; r<=r2; r++){
+            double oy = min(y2, _chip.bottom()+(r+1)*_bin_height) - max(y1, _chip.bottom()+r*_bin_height);
+            for(int c = c1; c<=c2; c++){
+                double ox = min(x2, _chip.left()+(c+1)*_bin_width) - max(x1, _chip.left()+c*_bin_width);
+                _fixed_area[r*_n+c] += ox*oy;
+            }
+        }
+    }
+}
+
+// bins [first, last] overlapping [lo, hi] along one direction
+void ElectrostaticDensity::binRange(double lo, double hi, double origin, double bin_size, int &first, int &last) const
+{
+    first = max((int)floor((lo - origin) / bin_size), 0);
+    last = min((int)floor((hi - origin) / bin_size), _n-1);
+}
+
+// the stretched module, kept inside the chip
+void ElectrostaticDensity::moduleBox(int m, const vector<double> &x, double &x1, double &y1, double &x2, double &y2) const
+{
+    double hw = min(_width[m], _chip.width()) / 2.;
+    double hh = min(_height[m], _chip.height()) / 2.;
+    double cx = min(max(x[2*m], _chip.left() + hw), _chip.right() - hw);
+    double cy = min(max(x[2*m+1], _chip.bottom() + hh), _chip.top() - hh);
+    x1 = cx - _width[m]/2.;
+    x2 = cx + _width[m]/2.;
+    y1 = cy - _height[m]/2.;
+    y2 = cy + _height[m]/2.;
+}
+
+// module area per bin, and the overflow
+void ElectrostaticDensity::spread(const vector<double> &x)
+{
+    int num_modules = _movable.size();
+    int num_bands = _band_sum.size();
+    _band_start.assign(num_bands+1, 0);
+    for(int pass = 0; pass<2; pass++){
+        // count modules per band, then fill them in module order
+        vector<int> fill(_band_start.begin(), _band_start.end()-1);
+        for(int m = 0; m<num_modules; m++){
+            if(!_movable[m]) continue;
+            double x1, y1, x2, y2;
+            moduleBox(m, x, x1, y1, x2, y2);
+            int r1, r2;
+            binRange(y1, y2, _chip.bottom(), _bin_height, r1, r2);
+            for(int band = r1/BAND_ROWS; band<=r2/BAND_ROWS; band++){
+                if(pass == 0) _band_start[band+1]++;
+                else _band_modules[fill[band]++] = m;
+            }
+        }
+        if(pass == 0){
+            for(int band = 0; band<num_bands; band++) _band_start[band+1] += _band_start[band];
+            _band_modules.resize(_band_start[num_bands]);
+        }
+    }
+    double bin_area = _bin_width*_bin_height;
+    parallelRun(_pool, num_bands, [&](int band){
+        int first_row = band*BAND_ROWS, last_row = min(first_row + BAND_ROWS, _n) - 1;
+        copy(_fixed_area.begin() + first_row*_n, _fixed_area.begin() + (last_row+1)*_n, _area.begin() + first_row*_n);
+        for(int k = _band_start[band]; k<_band_start[band+1]; k++){
+            int m = _band_modules[k];
+            double x1, y1, x2, y2;
+            moduleBox(m, x, x1, y1, x2, y2);
+            int c1, c2, r1, r2;
+            binRange(x1, x2, _chip.left(), _bin_width, c1, c2);
+            binRange(y1, y2, _chip.bottom(), _bin_height, r1, r2);
+            for(int r = max(r1, first_row); r<=min(r2, last_row); r++){
+                double oy = min(y2, _chip.bottom()+(r+1)*_bin_height) - max(y1, _chip.bottom()+r*_bin_height);
+                for(int c = c1; c<=c2; c++){
+                    double ox = min(x2, _chip.left()+(c+1)*_bin_width) - max(x1, _chip.left()+c*_bin_width);
+                    _area[r*_n+c] += ox*oy*_scale[m];
+                }
+            }
+        }
+        double band_overflow = 0.;
+        for(int b = first_row*_n; b<(last_row+1)*_n; b++){
+            band_overflow += max(_area[b] - _target_density*bin_area, 0.);
+        }
+        _band_sum[band] = band_overflow;
+    });
+    double total_overflow = 0.;
+    for(int band = 0; band<num_bands; band++) total_overflow += _band_sum[band];
+    _overflow = _movable_area > 0. ? total_overflow / _movable_area : 0.;
+}
+
+double ElectrostaticDensity::evaluate(const vector<double> &x, vector<double> *g, double weight)
+{
+    spread(x);
+    solvePoisson(g != NULL);
+    int num_bands = _band_sum.size();
+    parallelRun(_pool, num_bands, [&](int band){
+        double band_energy = 0.;
+        for(int b = band*BAND_ROWS*_n; b<min((band+1)*BAND_ROWS, _n)*_n; b++){
+            band_energy += _area[b]*_potential[b];
+        }
+        _band_sum[band] = band_energy;
+    });
+    double energy = 0.;
+    for(int band = 0; band<num_bands; band++) energy += _band_sum[band];
+    energy /= 2.;
+    if(!g) return energy;
+
+    // the force on a module is its charge in every bin times the field there
+    int num_modules = _movable.size();
+    int num_chunks = (num_modules + MODULE_CHUNK-1) / MODULE_CHUNK;
+    parallelRun(_pool, num_chunks, [&](int chunk){
+        for(int m = chunk*MODULE_CHUNK; m<min((chunk+1)*MODULE_CHUNK, num_modules); m++){
+            if(!_movable[m]) continue;
+            double x1, y1, x2, y2;
+            moduleBox(m, x, x1, y1, x2, y2);
+            int c1, c2, r1, r2;
+            binRange(x1, x2, _chip.left(), _bin_width, c1, c2);
+            binRange(y1, y2, _chip.bottom(), _bin_height, r1, r2);
+            double grad_x = 0., grad_y = 0.;
+            for(int r = r1; r<=r2; r++){
+                double oy = min(y2, _chip.bottom()+(r+1)*_bin_height) - max(y1, _chip.bottom()+r*_bin_height);
+                for(int c = c1; c<=c2; c++){
+                    double ox = min(x2, _chip.left()+(c+1)*_bin_width) - max(x1, _chip.left()+c*_bin_width);
+                    grad_x += ox*oy*_field_x[r*_n+c];
+                    grad_y += ox*oy*_field_y[r*_n+c];
+                }
+            }
+            (*g)[2*m] += weight*_scale[m]*grad_x;
+            (*g)[2*m+1] += weight*_scale[m]*grad_y;
+        }
+    });
+    return energy;
+}
+
+// potential, and field if asked, of the bin density _area/bin_area in bin units; the field is
+// converted to chip units, and the uniform component (u = v = 0) has no potential
+void ElectrostaticDensity::solvePoisson(bool field)
+{
+    double bin_area = _bin_width*_bin_height;
+    vector<double> &coef = _potential;
+    for(int b = 0; b<_n*_n; b++) coef[b] = _area[b] / bin_area;
+    _dct.dct2(coef, _pool);
+    // density = sum a(u,v) cos(w_u (c+1/2)) cos(w_v (r+1/2)) with a = 4 or 2 or 1 * dct / n^2
+    parallelRun(_pool, _n, [&](int v){
+        for(int u = 0; u<_n; u++){
+            int b = v*_n+u;
+            double norm = (u ? 2. : 1.) * (v ? 2. : 1.) / ((double)_n*_n);
+            double w2 = _freq[u]*_freq[u] + _freq[v]*_freq[v];
+            double a = b ? coef[b]*norm/w2 : 0.;
+            coef[b] = a;
+            if(field){
+                _field_x[b] = -a*_freq[u] / _bin_width;
+                _field_y[b] = -a*_freq[v] / _bin_height;
+            }
+        }
+    });
+    _dct.idct2(_potential, false, false, _pool);
+    if(field){
+        _dct.idct2(_field_x, true, false, _pool);
+        _dct.idct2(_field_y, false, true, _pool);
+    }
+}
@@ -0,0 +1,63 @@
+#define _GLIBCXX_USE_CXX11_ABI 0
+#ifndef ELECTROSTATICDENSITY_H
+#define ELECTROSTATICDENSITY_H
+
+#include "Placement.h"
+#include "Rectangle.h"
+#include "DCT.h"
+#include "Parallel.h"
+#include <vector>
+
+using namespace std;
+
+// ePlace density model: modules are charges spread onto an n x n bin grid, the potential
+// solves Poisson's equation -div grad psi = rho with Neumann boundary by cosine transforms,
+// and the density penalty is the potential energy. Movable modules smaller than sqrt(2) bins
+// are stretched with their charge density scaled down, fixed modules in the chip are
+// constant charges. Solutions hold module centers as (x[2*i], x[2*i+1]).
+// With a thread pool, every band of bin rows is spread by one task from the modules overlapping
+// it in module order, and every module gathers its own force, so results do not depend on the
+// number of threads.
+class ElectrostaticDensity
+{
+public:
+    // bin_res is rounded up to a power of two
+    ElectrostaticDensity(Placement &placement, int bin_res, double target_density = 1.);
+    // potential energy of the modules, and its gradient times weight added to g if not null
+    double evaluate(const vector<double> &x, vector<double> *g, double weight);
+    // total bin area above the target density per movable area, of the last evaluation
+    double overflow() const {return _overflow;}
+    int binRes() const {return _n;}
+    void setThreadPool(ThreadPool *pool) {_pool = pool;}
+
+private:
+    Rectangle _chip;
+    int _n;
+    double _bin_width;
+    double _bin_height;
+    double _target_density;
+    double _movable_area;
+    double _overflow;
+    vector<bool> _movable;
+    vector<double> _width; // stretched dimension
+    vector<double> _height;
+    vector<double> _scale; // charge density of the stretched module
+    vector<double> _fixed_area; // area of fixed modules per bin
+    vector<double> _area; // module area per bin
+    vector<double> _potential;
+    vector<double> _field_x; // d psi / dx per bin
+    vector<double> _field_y;
+    vector<double> _freq; // pi*u/n
+    DCT _dct;
+    ThreadPool *_pool; // not owned, serial if null
+    // movable modules overlapping band b of rows are _band_modules[_band_start[b].._band_start[b+1])
+    vector<int> _band_start;
+    vector<int> _band_modules;
+    vector<double> _band_sum; // partial sums of bands
+    void binRange(double lo, double hi, double origin, double bin_size, int &first, int &last) const;
+    void moduleBox(int m, const vector<double> &x, double &x1, double &y1, double &x2, double &y2) const;
+    void spread(const vector<double> &x);
+    void solvePoisson(bool field);
+};
+
+#endif // ELECTROSTATICDENSITY_H
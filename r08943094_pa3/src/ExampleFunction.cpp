@@ -4,7 +4,14 @@
 #include <string>
 #include <cstdlib>
 
-ExampleFunction::ExampleFunction(Placement &placement, int bin_res_in)
+// modules and bin rows per parallel task, fixed so that sums are taken in the same order
+static const int MODULE_CHUNK = 1024;
+static const int BAND_ROWS = 4;
+
+ExampleFunction::ExampleFunction(Placement &placement, int bin_res_in, WirelengthModel::Type wl_type,
+                                 DensityModel density_model_in, int num_threads)
+    : density_model(density_model_in), electrostatic(NULL), lambda_per_iteration(false), last_wl(0.), wirelength(placement, wl_type, 1.),
+      pool(num_threads > 1 ? new ThreadPool(num_threads) : NULL)
 {
     // density
     bin_res = bin_res_in;
@@ -40,89 +47,113 @@ ExampleFunction::ExampleFunction(Placement &placement, int bin_res_in)
     // Mb = 0.5;
     Mb = modules.size() / pow(bin_res, 2);
     // Mb = total_cell_area / (bin_width*bin_height*pow(bin_res, 2));
+    if(density_model == ELECTROSTATIC){
+        electrostatic = new ElectrostaticDensity(placement, bin_res);
+        electrostatic->setThreadPool(pool);
+        // weighted at the first gradient
+        lambda = 0.;
+    }
     
     // wl
-    nets.clear();
-    for(int n = 0; n<placement.numNets(); n++){
-        nets.push_back(&(placement.net(n)));
-    }
     double ub = pow(10, 1); // upper bound for exp(x/gamma)
     // gamma = 1000;
     gamma = max(chip.width(), chip.height()) / log(ub);
+    wirelength.setGamma(gamma);
+    wirelength.setThreadPool(pool);
+    chunk_sums.resize((modules.size() + MODULE_CHUNK-1) / MODULE_CHUNK);
 
     iter = 1;
     print();
 }
 
+ExampleFunction::~ExampleFunction()
+{
+    delete electrostatic;
+    delete pool;
+}
+
 void ExampleFunction::evaluateFG(const vector<double> &x, double &f, vector<double> &g)
 {
     cout<<"\n#Iter: "<<iter++<<"\n";
-    // evaluate objective function
-    evaluateF(x, f);
+    update_modules(x);
     cout<<"Average distance from chip center = "<<get_avg_dist()<<endl;
 
-    // evaluate gradient
-    // density
-    // cout<<"computing bin OxOy\n"<<flush;
-    total_OxOy = vector<double>(bins.size(), 0.);
-    for(int m = 0; m<modules.size(); m++){
-        Rectangle module = modules[m];
-        vector<int> overlapped_bins = get_overlapped_bins(module);
-        for(int i = 0; i<overlapped_bins.size(); i++){
-            int b = overlapped_bins[i];
-            Rectangle &bin = bins[b];
-            total_OxOy[b] += Ox(bin, module)*Oy(bin, module);
-        }
+    // wirelength and its gradient in one pass over the nets
+    g.assign(dimension(), 0.);
+    double wl = wirelength.evaluate(x, &g);
+    if(lambda_per_iteration){
+        last_wl = wl;
+        last_wl_grad = g;
     }
-    // wl
-    // cout<<"computing net wl\n"<<flush;
-    net_total_exp_x = vector<double>(nets.size(), 0.);
-    net_total_exp_minx = vector<double>(nets.size(), 0.);
-    net_total_exp_y = vector<double>(nets.size(), 0.);
-    net_total_exp_miny = vector<double>(nets.size(), 0.);
-    for(int n = 0; n<nets.size(); n++){
-        Net *net = nets[n];
-        for(int p = 0; p<net->numPins(); p++){
-            int m_id = net->pin(p).moduleId();
-            double xp = modules[m_id].centerX();
-            double yp = modules[m_id].centerY();
-            net_total_exp_x[n] += exp(xp/gamma);
-            net_total_exp_minx[n] += exp(-xp/gamma);
-            net_total_exp_y[n] += exp(yp/gamma);
-            net_total_exp_miny[n] += exp(-yp/gamma);
+    if(density_model == ELECTROSTATIC){
+        if(lambda == 0.){
+            // as ePlace, the initial weight balances wirelength and density gradients
+            vector<double> density_grad(dimension(), 0.);
+            electrostatic->evaluate(x, &density_grad, 1.);
+            double wl_norm = 0., density_norm = 0.;
+            for(int i = 0; i<g.size(); i++){
+                wl_norm += abs(g[i]);
+                density_norm += abs(density_grad[i]);
+            }
+            lambda = density_norm > 0. ? wl_norm / density_norm : 1.;
         }
+        f = wl + lambda*electrostatic->evaluate(x, &g, lambda);
+        cout<<"Density overflow = "<<electrostatic->overflow()<<", lambda = "<<lambda<<endl;
+        if(!lambda_per_iteration) lambda *= 1.1;
+        return;
     }
-    wl_x_grad = vector<double>(modules.size(), 0.);
-    wl_y_grad = vector<double>(modules.size(), 0.);
-    total_wl_grad();
+    f = wl + lambda*total_density();
+
+    // density gradient
+    // cout<<"computing bin OxOy\n"<<flush;
+    bin_OxOy();
 
     // grad
     // cout<<"computing gradient\n"<<flush;
-    for(int i = 0; i<modules.size(); i++){
-        // g[2*i] = total_wl_x_grad(i) + lambda*total_density_x_grad(i);
-        // g[2*i+1] = total_wl_y_grad(i) + lambda*total_density_y_grad(i);
-        g[2*i] = wl_x_grad[i] + lambda*total_density_x_grad(i);
-        g[2*i+1] = wl_y_grad[i] + lambda*total_density_y_grad(i);
-        // g[2*i] = lambda*total_density_x_grad(i);
-        // g[2*i+1] = lambda*total_density_y_grad(i);
+    parallelRun(pool, chunk_sums.size(), [&](int c){
+        for(int i = c*MODULE_CHUNK; i<min<int>((c+1)*MODULE_CHUNK, modules.size()); i++){
+            g[2*i] += lambda*total_density_x_grad(i);
+            g[2*i+1] += lambda*total_density_y_grad(i);
+        }
+    });
+    if(!lambda_per_iteration) lambda *= 2.;
+}
+
+void ExampleFunction::next_iteration(double &f, vector<double> &g)
+{
+    double factor = density_model == ELECTROSTATIC ? 1.1 : 2.;
+    f = last_wl + (f - last_wl)*factor;
+    for(size_t i = 0; i<g.size(); i++){
+        g[i] = last_wl_grad[i] + (g[i] - last_wl_grad[i])*factor;
     }
-    lambda *= 2.;
+    lambda *= factor;
 }
 
 void ExampleFunction::evaluateF(const vector<double> &x, double &f)
 {
     // cout<<"calculate objective\n"<<flush;
+    update_modules(x);
+    // objective function
+    f = wirelength.evaluate(x, NULL) + lambda*density(x);
+    // f = lambda*total_density();
+}
+
+double ExampleFunction::density(const vector<double> &x)
+{
+    if(density_model == ELECTROSTATIC) return electrostatic->evaluate(x, NULL, 0.);
+    return total_density();
+}
+
+void ExampleFunction::update_modules(const vector<double> &x)
+{
     // update coordinate for all modules
-    // module bottom-left coordinate = (x[2*i], x[2*i+1])
+    // module center coordinate = (x[2*i], x[2*i+1])
     for(int i = 0; i<modules.size(); i++){
         modules[i] = Rectangle(x[2*i] - 0.5*modules[i].width(),
                                 x[2*i+1] - 0.5*modules[i].height(),
                                 x[2*i] + 0.5*modules[i].width(),
                                 x[2*i+1] + 0.5*modules[i].height());
     }
-    // objective function
-    f = total_wirelength() + lambda*total_density();
-    // f = lambda*total_density();
 }
 
 unsigned ExampleFunction::dimension()
@@ -152,17 +183,53 @@ inline double ExampleFunction::Oy(Rectangle &bin, Rectangle &module)
 
 double ExampleFunction::total_density()
 {
+    parallelRun(pool, chunk_sums.size(), [&](int c){
+        double density = 0.;
+        for(int m = c*MODULE_CHUNK; m<min<int>((c+1)*MODULE_CHUNK, modules.size()); m++){
+            Rectangle &module = modules[m];
+            vector<int> overlapped_bins = get_overlapped_bins(module);
+            for(int i = 0; i<overlapped_bins.size(); i++){
+                int b = overlapped_bins[i];
+                Rectangle &bin = bins[b];
+                density += pow(Ox(bin, module)*Oy(bin, module) - Mb, 2);
+            }
+        }
+        chunk_sums[c] = density;
+    });
     double total_density = 0.;
+    for(int c = 0; c<chunk_sums.size(); c++) total_density += chunk_sums[c];
+    return total_density;
+}
+
+// OxOy of every bin summed over modules, each band of bin rows by one task from the modules
+// overlapping it in module order
+void ExampleFunction::bin_OxOy()
+{
+    total_OxOy.assign(bins.size(), 0.);
+    int num_bands = ((int)bin_res + BAND_ROWS-1) / BAND_ROWS;
+    vector<vector<int> > band_modules(num_bands);
+    vector<int> first_row(modules.size()), last_row(modules.size());
     for(int m = 0; m<modules.size(); m++){
-        Rectangle &module = modules[m];
-        vector<int> overlapped_bins = get_overlapped_bins(module);
-        for(int i = 0; i<overlapped_bins.size(); i++){
-            int b = overlapped_bins[i];
-            Rectangle &bin = bins[b];
-            total_density += pow(Ox(bin, module)*Oy(bin, module) - Mb, 2);
+        first_row[m] = max(floor(bin_res * (modules[m].bottom() - chip.bottom()) / chip.height()), 0.);
+        last_row[m] = min(floor(bin_res * (modules[m].top() - chip.bottom()) / chip.height()), bin_res-1.);
+        for(int band = first_row[m]/BAND_ROWS; band<=last_row[m]/BAND_ROWS; band++){
+            band_modules[band].push_back(m);
         }
     }
-    return total_density;
+    parallelRun(pool, num_bands, [&](int band){
+        for(int k = 0; k<band_modules[band].size(); k++){
+            int m = band_modules[band][k];
+            Rectangle &module = modules[m];
+            int l = max(floor(bin_res * (module.left() - chip.left()) / chip.width()), 0.);
+            int r = min(floor(bin_res * (module.right() - chip.left()) / chip.width()), bin_res-1.);
+            for(int i = max(first_row[m], band*BAND_ROWS); i<=min(last_row[m], (band+1)*BAND_ROWS-1); i++){ // row
+                for(int j = l; j<=r; j++){ // col
+                    int b = i*(int)bin_res + j;
+                    total_OxOy[b] += Ox(bins[b], module)*Oy(bins[b], module);
+                }
+            }
+        }
+    });
 }
 
 inline double ExampleFunction::dOxdx(Rectangle &bin, Rectangle &module)
@@ -213,77 +280,6 @@ double ExampleFunction::total_density_y_grad(size_t idx)
     return total_grad;
 }
 
-inline double ExampleFunction::lse(vector<double> vals, double scale)
-{
-    double lse = 0.;
-    for(int i = 0; i<vals.size(); i++){
-        lse += exp(scale*vals[i]/gamma);
-    }
-    return log(lse);
-}
-
-double ExampleFunction::total_wirelength()
-{
-    double total_wl = 0.;
-    for(int n = 0; n<nets.size(); n++){
-        Net *net = nets[n];
-        vector<double> xs(net->numPins(), 0.);
-        vector<double> ys(net->numPins(), 0.);
-        for(int p = 0; p<net->numPins(); p++){
-            int m_id = net->pin(p).moduleId();
-            xs[p] = modules[m_id].centerX();
-            ys[p] = modules[m_id].centerY();
-            total_wl += lse(xs, 1) + lse(xs, -1) + lse(ys, 1) + lse(ys, -1);
-        }
-    }
-    return gamma * total_wl;
-}
-
-double ExampleFunction::dLSEdx(int net_id, double x)
-{
-    return exp(x/gamma) / (gamma*net_total_exp_x[net_id]) + -exp(-x/gamma) / (gamma*net_total_exp_minx[net_id]);
-}
-
-double ExampleFunction::dLSEdy(int net_id, double y)
-{
-    return exp(y/gamma) / (gamma*net_total_exp_y[net_id]) + -exp(-y/gamma) / (gamma*net_total_exp_miny[net_id]);
-}
-
-double ExampleFunction::total_wl_x_grad(size_t idx)
-{
-    double x = modules[idx].centerX();
-    double total_grad = 0.;
-    for(int n = 0; n<nets.size(); n++){
-        total_grad += dLSEdx(n, x);
-    }
-    return gamma*total_grad;
-}
-
-double ExampleFunction::total_wl_y_grad(size_t idx)
-{
-    double y = modules[idx].centerY();
-    double total_grad = 0.;
-    for(int n = 0; n<nets.size(); n++){
-        total_grad += dLSEdy(n, y);
-    }
-    return gamma*total_grad;
-}
-
-void ExampleFunction::total_wl_grad()
-{
-    for(int n = 0; n<nets.size(); n++){
-        Net *net = nets[n];
-        for(int p = 0; p<net->numPins(); p++){
-            Pin pin = net->pin(p);
-            int m_id = pin.moduleId();
-            double x = modules[m_id].centerX();
-            double y = modules[m_id].centerY();
-            wl_x_grad[m_id] += dLSEdx(n, x);
-            wl_y_grad[m_id] += dLSEdy(n, y);
-        }
-    }
-}
-
 inline bool ExampleFunction::overlap(Rectangle &bin, Rectangle &module)
 {
     bool horizontal_overlap1 = module.left() > bin.left() && module.left() < bin.right()
@@ -328,4 +324,8 @@ void ExampleFunction::print(){
     cout<<"lambda = "<<lambda<<"\n";
     cout<<"alpha = "<<alpha<<"\n";
     cout<<"gamma = "<<gamma<<"\n";
+    cout<<"density model = "<<(density_model == ELECTROSTATIC ? "electrostatic" : "sigmoid");
+    if(electrostatic) cout<<", "<<electrostatic->binRes()<<"x"<<electrostatic->binRes()<<" bins";
+    cout<<"\n";
+    cout<<"wirelength model = "<<(wirelength.type() == WirelengthModel::LSE ? "LSE" : "WA")<<"\n";
 }
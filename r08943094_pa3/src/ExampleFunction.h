@@ -5,11 +5,24 @@
 #include "NumericalOptimizerInterface.h"
 #include "Placement.h"
 #include "Rectangle.h"
+#include "WirelengthModel.h"
+#include "ElectrostaticDensity.h"
+#include "Parallel.h"
 
 class ExampleFunction : public NumericalOptimizerInterface
 {
+public:
+    // SIGMOID: squared sigmoid overlap of modules and bins against the target density
+    // ELECTROSTATIC: potential energy of ElectrostaticDensity
+    enum DensityModel {SIGMOID, ELECTROSTATIC};
+private:
     // density
+    DensityModel density_model;
+    ElectrostaticDensity *electrostatic; // only for ELECTROSTATIC
     double lambda; // density weight
+    bool lambda_per_iteration; // raised by next_iteration() instead of every evaluateFG
+    double last_wl; // wirelength and its gradient of the last evaluateFG, kept if lambda_per_iteration
+    vector<double> last_wl_grad;
     double Mb; // desired density for a bin
     double alpha; // sigmoid parameter
     double bin_res; // bin resolution, num of bins per dimension
@@ -19,19 +32,22 @@ class ExampleFunction : public NumericalOptimizerInterface
     vector<double> total_OxOy;
     // wl
     double gamma; // lse parameter
-    vector<Net*> nets;
-    vector<double> net_total_exp_x;
-    vector<double> net_total_exp_minx;
-    vector<double> net_total_exp_y;
-    vector<double> net_total_exp_miny;
-    vector<double> wl_x_grad;
-    vector<double> wl_y_grad;
+    WirelengthModel wirelength;
     // others
     int iter;
+    ThreadPool *pool; // shared by the wirelength and density passes
+    vector<double> chunk_sums; // partial sums of module chunks
 public:
-    ExampleFunction(Placement &placement, int bin_res_in);
+    ExampleFunction(Placement &placement, int bin_res_in, WirelengthModel::Type wl_type = WirelengthModel::LSE,
+                    DensityModel density_model_in = SIGMOID, int num_threads = 1);
+    ~ExampleFunction();
 
     void evaluateFG(const vector<double> &x, double &f, vector<double> &g);
+    // for optimizers trying several solutions per iteration: the density weight is raised once per
+    // iteration by next_iteration(), which also rescales the objective f and gradient g of the last
+    // evaluateFG to the new weight
+    void set_lambda_per_iteration(bool val) {lambda_per_iteration = val;}
+    void next_iteration(double &f, vector<double> &g);
     void evaluateF(const vector<double> &x, double &f);
     unsigned dimension();
 
@@ -41,20 +57,17 @@ public:
     double Ox(Rectangle &bin, Rectangle &module);
     double Oy(Rectangle &bin, Rectangle &module);
     double total_density();
+    void bin_OxOy();
+    double density(const vector<double> &x);
+    // density overflow of the last evaluation, -1 if the density model does not measure it
+    double overflow() {return electrostatic ? electrostatic->overflow() : -1.;}
     // density gradient
     double dOxdx(Rectangle &bin, Rectangle &module);
     double dOydy(Rectangle &bin, Rectangle &module);
     double total_density_x_grad(size_t idx);
     double total_density_y_grad(size_t idx);
-    // wirelength, suppose all pins are at the center of the module
-    double lse(vector<double> vals, double scale);
-    double total_wirelength();
-    // wirelength gradient
-    double dLSEdx(int net_id, double x);
-    double dLSEdy(int net_id, double y);
-    double total_wl_x_grad(size_t idx);
-    double total_wl_y_grad(size_t idx);
-    void total_wl_grad();
+    // module coordinates of a solution
+    void update_modules(const vector<double> &x);
     // others
     bool overlap(Rectangle &bin, Rectangle &module);
     vector<int> get_overlapped_bins(Rectangle &module);
@@ -1,13 +1,19 @@
 #include "GlobalPlacer.h"
 #include "ExampleFunction.h"
 #include "NumericalOptimizer.h"
+#include "NesterovOptimizer.h"
+#include "fplib.h"
+#include "ParamPlacement.h"
 #include <cstdlib>
 #include <cmath>
+#include <algorithm>
 
 GlobalPlacer::GlobalPlacer(Placement &placement)
-	:_placement(placement)
+	:_placement(placement), density_model(ExampleFunction::SIGMOID), nesterov(false)
 {
     num_iters = 80;
+    nesterov_iters = 1000;
+    target_overflow = 0.1;
     double max_module_dim = 0.;
     for(int m = 0; m<placement.numModules(); m++){
         max_module_dim = max(max_module_dim, placement.module(m).width());
@@ -38,31 +44,139 @@ void GlobalPlacer::place()
 	// if you use other methods, you can skip and delete it directly.
 	//////////////////////////////////////////////////////////////////
     srand(0);
-	ExampleFunction ef(_placement, bin_res); // require to define the object function and gradient function
+	ExampleFunction ef(_placement, bin_res, WirelengthModel::LSE, density_model, param.threadNum); // require to define the object function and gradient function
 
     // module mi center coordinate = (x[2*i], x[2*i+1])
     vector<double> x(ef.dimension(), 0.);
     // initialize the solution vector
     double radius = 1.*max(_placement.rectangleChip().width(), _placement.rectangleChip().height())/2.;
+    // Nesterov spreads modules out of a cluster at the center until the overflow target, as ePlace
+    if(nesterov) radius /= 10.;
     // double radius = 1000.;
     for(int m = 0; m<_placement.numModules(); m++){
         x[2*m] = rand()%(int)(2*radius) -radius + _placement.rectangleChip().centerX();
         x[2*m+1] = rand()%(int)(2*radius) -radius + _placement.rectangleChip().centerY();
+        // pre-placed macros stay where they are
+        if(is_preplaced(m)){
+            x[2*m] = _placement.module(m).centerX();
+            x[2*m+1] = _placement.module(m).centerY();
+        }
     }
 
-    NumericalOptimizer no(ef);
-    no.setX(x); // set initial solution
-    no.setNumIteration(num_iters); // user-specified parameter
-    no.setStepSizeBound(step_size); // user-specified parameter
-    no.solve(); // Conjugate Gradient solver
+    vector<double> solution(x.size());
+    if(nesterov){
+        // backtracking trials of an iteration evaluate the same objective
+        ef.set_lambda_per_iteration(true);
+        NesterovOptimizer no(ef);
+        no.setX(x);
+        no.setNumIteration(nesterov_iters);
+        no.setStepSizeBound(step_size);
+        no.setOverflowTarget(target_overflow, [&]{return ef.overflow();});
+        no.setIterationCallback([&](double &f, vector<double> &grad){ef.next_iteration(f, grad);});
+        no.solve(); // Nesterov's method
+        cout << "Objective: " << no.objective() << endl;
+        for(size_t i = 0; i<x.size(); i++) solution[i] = no.x(i);
+    }
+    else{
+        NumericalOptimizer no(ef);
+        no.setX(x); // set initial solution
+        no.setNumIteration(num_iters); // user-specified parameter
+        no.setStepSizeBound(step_size); // user-specified parameter
+        no.solve(); // Conjugate Gradient solver
 
-    cout << "Objective: " << no.objective() << endl;
+        cout << "Objective: " << no.objective() << endl;
+        for(size_t i = 0; i<x.size(); i++) solution[i] = no.x(i);
+    }
 	////////////////////////////////////////////////////////////////
 
     // place all modules
     for(int m = 0; m<_placement.numModules(); m++){
-        _placement.module(m).setCenterPosition(no.x(2*m), no.x(2*m+1));
+        if(is_preplaced(m)) continue;
+        _placement.module(m).setCenterPosition(solution[2*m], solution[2*m+1]);
+    }
+}
+
+// Movable modules taller than a row are floorplanned as hard blocks by the B*-tree floorplanner
+// of PA2 within the chip, with nets among them and fixed modules as terminals. Standard cells are
+// not placed yet and left out of the nets. Placed macros become fixed for the rest of the flow.
+void GlobalPlacer::place_macros(double time_limit)
+{
+    int num_modules = _placement.numModules();
+    double row_height = _placement.getRowHeight();
+    FloorplanInstance fp(floor(chip.width()), floor(chip.height()), 0.5);
+    fp.set_time_limit(time_limit);
+    vector<int> block_of(num_modules, -1);
+    vector<int> terminal_of(num_modules, -1);
+    vector<int> macros;
+    for(int m = 0; m<num_modules; m++){
+        Module &module = _placement.module(m);
+        if(module.isFixed() || module.height() <= row_height) continue;
+        block_of[m] = fp.add_block(ceil(module.width()), ceil(module.height()));
+        macros.push_back(m);
+    }
+    if(macros.empty()) return;
+    int num_nets = 0;
+    for(unsigned n = 0; n<_placement.numNets(); n++){
+        Net &net = _placement.net(n);
+        vector<int> block_ids, terminal_ids;
+        for(unsigned p = 0; p<net.numPins(); p++){
+            int m = net.pin(p).moduleId();
+            if(block_of[m] >= 0){
+                if(find(block_ids.begin(), block_ids.end(), block_of[m]) == block_ids.end())
+                    block_ids.push_back(block_of[m]);
+            }
+            else if(_placement.module(m).isFixed()){
+                if(terminal_of[m] < 0){
+                    Module &module = _placement.module(m);
+                    terminal_of[m] = fp.add_terminal(module.centerX() - chip.left(), module.centerY() - chip.bottom());
+                }
+                if(find(terminal_ids.begin(), terminal_ids.end(), terminal_of[m]) == terminal_ids.end())
+                    terminal_ids.push_back(terminal_of[m]);
+            }
+        }
+        if(block_ids.empty() || block_ids.size()+terminal_ids.size() < 2) continue;
+        fp.add_net(block_ids.data(), block_ids.size(), terminal_ids.data(), terminal_ids.size());
+        num_nets++;
+    }
+    // a floorplan exceeding the chip leaves the macros to global placement
+    if(!fp.floorplan()){
+        cout<<"Macro floorplan of ("<<fp.get_chip_width()<<","<<fp.get_chip_height()<<") exceeds the chip, macros stay movable"
+            <<", runtime = "<<get_time()<<"\n";
+        return;
+    }
+    // the floorplanner knows nothing of fixed modules in the chip,
+    // so macros placed over one of them stay movable
+    vector<int> blockages;
+    for(int m = 0; m<num_modules; m++){
+        Module &module = _placement.module(m);
+        if(!module.isFixed()) continue;
+        if(module.x() < chip.right() && module.x() + module.width() > chip.left()
+           && module.y() < chip.top() && module.y() + module.height() > chip.bottom()) blockages.push_back(m);
+    }
+    int num_fixed = 0;
+    for(int m : macros){
+        Module &module = _placement.module(m);
+        int x, y, width, height;
+        fp.get_block(block_of[m], x, y, width, height);
+        double left = chip.left() + x, bottom = chip.bottom() + y;
+        bool blocked = false;
+        for(int b : blockages){
+            Module &blockage = _placement.module(b);
+            if(left < blockage.x() + blockage.width() && blockage.x() < left + width
+               && bottom < blockage.y() + blockage.height() && blockage.y() < bottom + height){
+                blocked = true;
+                break;
+            }
+        }
+        if(blocked) continue;
+        // the floorplanner rotates blocks by swapping their dimension
+        if(width != (int)ceil(module.width())) module.setOrient(Module::OR_W);
+        module.setPosition(left, bottom);
+        module.setIsFixed(true);
+        num_fixed++;
     }
+    cout<<"Pre-placed "<<num_fixed<<" of "<<macros.size()<<" macros with "<<num_nets<<" nets in ("<<fp.get_chip_width()<<","<<fp.get_chip_height()<<")"
+        <<", "<<macros.size() - num_fixed<<" over fixed modules stay movable, runtime = "<<get_time()<<"\n";
 }
 
 void GlobalPlacer::SA_place()
@@ -110,7 +224,7 @@ void GlobalPlacer::initial_place()
     int col = 0;
     bool module_placed[num_modules] = {};
     for(int m = 0; m<num_modules; m++){
-        if(module_placed[m]) continue;
+        if(module_placed[m] || is_preplaced(m)) continue;
         module_placed[m] = true;
         Module &module = _placement.module(m);
         double x = chip.left() + (double)(col+1)*col_width + x_offset;
@@ -140,7 +254,7 @@ void GlobalPlacer::choose_modules()
         x2 = _placement.module(m2).rectangle().centerX();
         y2 = _placement.module(m2).rectangle().centerY();
         // cout<<m1<<":("<<x1<<","<<y1<<"), "<<m2<<":("<<x2<<","<<y2<<")\n"<<endl;
-    }while(abs(x1-x2) < chip.width()*T && abs(y1-y2) < chip.height()*T);
+    }while((abs(x1-x2) < chip.width()*T && abs(y1-y2) < chip.height()*T) || is_preplaced(m1) || is_preplaced(m2));
 }
 
 void GlobalPlacer::swap()
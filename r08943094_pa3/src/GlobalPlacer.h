@@ -3,6 +3,7 @@
 #define GLOBALPLACER_H
 
 #include "Placement.h"
+#include "ExampleFunction.h"
 #include <cstdlib>
 #include <cstdio>
 #include <fstream>
@@ -13,6 +14,12 @@ class GlobalPlacer
 public:
     GlobalPlacer(Placement &placement);
 	void place();
+    // density model of the analytical placement of place()
+    void set_density_model(ExampleFunction::DensityModel model) {density_model = model;}
+    // Nesterov's method (NesterovOptimizer) instead of conjugate gradient in place()
+    void set_nesterov(bool use) {nesterov = use;}
+    // floorplan movable macros in the chip and fix them before global placement
+    void place_macros(double time_limit);
     void plotPlacementResult( const string outfilename, bool isPrompt = false );
     // SA
     void SA_place();
@@ -24,9 +31,15 @@ public:
 private:
     Placement& _placement;
     void plotBoxPLT( ofstream& stream, double x1, double y1, double x2, double y2 );
+    // fixed macros, such as those of place_macros, stay in place; other fixed modules are moved as before
+    bool is_preplaced(int m) {return _placement.module(m).isFixed() && _placement.module(m).height() > _placement.getRowHeight();}
     int num_iters;
     double step_size;
     int bin_res;
+    ExampleFunction::DensityModel density_model;
+    bool nesterov;
+    int nesterov_iters; // at most, Nesterov stops earlier at target_overflow
+    double target_overflow;
     // SA
     Rectangle chip;
     double T;
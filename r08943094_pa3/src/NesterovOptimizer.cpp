@@ -0,0 +1,85 @@
+#include "NesterovOptimizer.h"
+#include <cmath>
+#include <iostream>
+
+NesterovOptimizer::NesterovOptimizer(NumericalOptimizerInterface &noi)
+    : _numIteration(1000), _stepSizeBound(HUGE_VAL), _overflowTarget(-1.), _numIterationsRun(0), _numEvaluations(0), _f(0.), _noi(noi)
+{
+}
+
+static double distance(const vector<double> &a, const vector<double> &b)
+{
+    double sum = 0.;
+    for(size_t i = 0; i<a.size(); i++) sum += (a[i]-b[i])*(a[i]-b[i]);
+    return sqrt(sum);
+}
+
+// the step is limited so that no coordinate moves more than the bound
+double NesterovOptimizer::boundStep(double step, const vector<double> &grad)
+{
+    double max_grad = 0.;
+    for(size_t i = 0; i<grad.size(); i++) max_grad = max(max_grad, fabs(grad[i]));
+    if(max_grad > 0. && step*max_grad > _stepSizeBound) step = _stepSizeBound / max_grad;
+    return step;
+}
+
+void NesterovOptimizer::solve()
+{
+    unsigned n = _noi.dimension();
+    if(_x.size() != n) _x.assign(n, 0.);
+    _numIterationsRun = 0;
+    _numEvaluations = 0;
+    // u: major solution, v: reference solution where gradients are taken, a: acceleration
+    vector<double> u = _x, v = _x, grad(n), u_new(n), v_new(n), grad_new(n);
+    double a = 1.;
+    double f_new;
+    _noi.evaluateFG(v, _f, grad);
+    _numEvaluations++;
+
+    // initial Lipschitz prediction from a step along the gradient
+    double step = boundStep(HUGE_VAL, grad);
+    if(!(step < HUGE_VAL)) return; // zero gradient
+    for(unsigned i = 0; i<n; i++) v_new[i] = v[i] - step*grad[i];
+    _noi.evaluateFG(v_new, f_new, grad_new);
+    _numEvaluations++;
+    double grad_dist = distance(grad, grad_new);
+    if(grad_dist > 0.) step = boundStep(distance(v, v_new) / grad_dist, grad);
+
+    for(unsigned iter = 0; iter<_numIteration; iter++){
+        double a_new = (1. + sqrt(4.*a*a + 1.)) / 2.;
+        const int MAX_BACKTRACKS = 10;
+        for(int k = 0; k<MAX_BACKTRACKS; k++){
+            for(unsigned i = 0; i<n; i++){
+                u_new[i] = v[i] - step*grad[i];
+                v_new[i] = u_new[i] + (a - 1.)/a_new * (u_new[i] - u[i]);
+            }
+            _noi.evaluateFG(v_new, f_new, grad_new);
+            _numEvaluations++;
+            if(!isfinite(f_new)) break;
+            grad_dist = distance(grad, grad_new);
+            // a zero change of gradient predicts no Lipschitz constant, keep the step
+            double predicted = grad_dist > 0. ? boundStep(distance(v, v_new) / grad_dist, grad_new) : step;
+            bool accepted = predicted >= 0.95*step;
+            step = predicted;
+            if(accepted) break;
+        }
+        // diverged, as when a density weight grows without bound; the last solution stays
+        if(!isfinite(f_new)){
+            cout<<"Objective is not finite, stopped after "<<_numIterationsRun<<" iterations\n";
+            break;
+        }
+        u.swap(u_new);
+        v.swap(v_new);
+        grad.swap(grad_new);
+        _f = f_new;
+        a = a_new;
+        _numIterationsRun++;
+        if(_iterationCallback) _iterationCallback(_f, grad);
+        if(_overflow && _overflow() >= 0. && _overflow() <= _overflowTarget){
+            cout<<"Overflow target "<<_overflowTarget<<" reached after "<<_numIterationsRun<<" iterations\n";
+            break;
+        }
+    }
+    _x = v;
+    cout<<"Nesterov: "<<_numIterationsRun<<" iterations, "<<_numEvaluations<<" evaluations\n";
+}
@@ -0,0 +1,57 @@
+#define _GLIBCXX_USE_CXX11_ABI 0
+#ifndef NESTEROVOPTIMIZER_H
+#define NESTEROVOPTIMIZER_H
+
+#include "NumericalOptimizerInterface.h"
+#include <functional>
+
+// Nesterov's accelerated gradient method as in ePlace, a drop-in alternative to the CG
+// NumericalOptimizer: the step is the inverse of the Lipschitz constant predicted from the last
+// two reference solutions and gradients, and a step is taken again with the new prediction
+// while it shrinks by more than 5% (backtracking). Every trial costs one evaluateFG and no
+// evaluateF. Stops after the number of iterations or once the density overflow reaches its target.
+class NesterovOptimizer
+{
+public:
+    NesterovOptimizer(NumericalOptimizerInterface &noi);
+
+    // set
+    void setNumIteration(unsigned num) {_numIteration = num;}
+    void setStepSizeBound(double size) {_stepSizeBound = size;} // largest move of a coordinate
+    void setX(const vector<double> &x) {_x = x;}
+    // overflow() is read after every iteration, a negative value is never reached
+    void setOverflowTarget(double target, const function<double()> &overflow) {
+        _overflowTarget = target;
+        _overflow = overflow;
+    }
+    // called once per iteration with the objective and gradient of the new reference solution,
+    // which it updates if it changes the objective, as a penalty weight raised per iteration
+    void setIterationCallback(const function<void(double &f, vector<double> &grad)> &callback) {_iterationCallback = callback;}
+
+    // operation
+    void solve();
+
+    // get, of the last reference solution
+    unsigned dimension() {return _x.size();}
+    double objective() {return _f;}
+    double x(unsigned i) {return _x[i];}
+    unsigned numIterations() {return _numIterationsRun;}
+    unsigned numEvaluations() {return _numEvaluations;}
+
+private:
+    // parameter
+    unsigned _numIteration;
+    double _stepSizeBound;
+    double _overflowTarget;
+    function<double()> _overflow;
+    function<void(double &, vector<double> &)> _iterationCallback;
+
+    unsigned _numIterationsRun;
+    unsigned _numEvaluations;
+    double _f;
+    vector<double> _x;
+    NumericalOptimizerInterface &_noi;
+    double boundStep(double step, const vector<double> &grad);
+};
+
+#endif // NESTEROVOPTIMIZER_H
@@ -0,0 +1,15 @@
+#define _GLIBCXX_USE_CXX11_ABI 0
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+// the ThreadPool of PA2, linked from libfp.a; its interface crosses no ABI-dependent type
+#include "threadpool.h"
+
+// fn(0) ... fn(n-1) on the pool, or in order on the calling thread without one
+inline void parallelRun(ThreadPool *pool, int n, const function<void(int)> &fn)
+{
+    if(pool) pool->run(n, fn);
+    else for(int i = 0; i<n; i++) fn(i);
+}
+
+#endif // PARALLEL_H
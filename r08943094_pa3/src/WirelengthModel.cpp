@@ -0,0 +1,136 @@
+#include "WirelengthModel.h"
+#include <cmath>
+#include <algorithm>
+
+// nets and modules per parallel task, fixed so that sums are taken in the same order
+static const int NET_CHUNK = 512;
+static const int MODULE_CHUNK = 4096;
+
+WirelengthModel::WirelengthModel(Placement &placement, Type type, double gamma)
+    : _type(type), _gamma(gamma), _num_modules(placement.numModules()), _pool(NULL), _net_start(1, 0)
+{
+    for(unsigned n = 0; n<placement.numNets(); n++){
+        Net &net = placement.net(n);
+        for(unsigned p = 0; p<net.numPins(); p++){
+            _pin_module.push_back(net.pin(p).moduleId());
+        }
+        _net_start.push_back(_pin_module.size());
+    }
+    buildIndex();
+}
+
+WirelengthModel::WirelengthModel(const vector<int> &net_start, const vector<int> &pin_module, int num_modules, Type type, double gamma)
+    : _type(type), _gamma(gamma), _num_modules(num_modules), _pool(NULL), _net_start(net_start), _pin_module(pin_module)
+{
+    buildIndex();
+}
+
+// pins of every module and scratch of every net chunk
+void WirelengthModel::buildIndex()
+{
+    _module_pin_start.assign(_num_modules+1, 0);
+    for(unsigned p = 0; p<numPins(); p++) _module_pin_start[_pin_module[p]+1]++;
+    for(int m = 0; m<_num_modules; m++) _module_pin_start[m+1] += _module_pin_start[m];
+    _module_pins.resize(numPins());
+    vector<int> fill(_module_pin_start.begin(), _module_pin_start.end()-1);
+    for(unsigned p = 0; p<numPins(); p++) _module_pins[fill[_pin_module[p]]++] = p;
+
+    int num_chunks = (numNets() + NET_CHUNK-1) / NET_CHUNK;
+    _scratch.resize(num_chunks);
+    _chunk_wl.resize(num_chunks);
+    for(int c = 0; c<num_chunks; c++){
+        int max_degree = 0;
+        for(unsigned n = c*NET_CHUNK; n<min<unsigned>((c+1)*NET_CHUNK, numNets()); n++){
+            max_degree = max(max_degree, _net_start[n+1] - _net_start[n]);
+        }
+        _scratch[c].coord.resize(max_degree);
+        _scratch[c].exp_max.resize(max_degree);
+        _scratch[c].exp_min.resize(max_degree);
+    }
+    _pin_grad[0].assign(numPins(), 0.);
+    _pin_grad[1].assign(numPins(), 0.);
+}
+
+double WirelengthModel::evaluate(const vector<double> &x, vector<double> *g)
+{
+    int num_chunks = _chunk_wl.size();
+    parallelRun(_pool, num_chunks, [&](int c){
+        Scratch &scratch = _scratch[c];
+        double chunk_wl = 0.;
+        for(unsigned n = c*NET_CHUNK; n<min<unsigned>((c+1)*NET_CHUNK, numNets()); n++){
+            const int *pins = &_pin_module[_net_start[n]];
+            int num_pins = _net_start[n+1] - _net_start[n];
+            // a single pin has no wirelength in either model, its gradient stays 0
+            if(num_pins < 2) continue;
+            for(int dim = 0; dim<2; dim++){
+                for(int k = 0; k<num_pins; k++){
+                    scratch.coord[k] = x[2*pins[k]+dim];
+                }
+                chunk_wl += netWirelength(scratch, num_pins, g ? &_pin_grad[dim][_net_start[n]] : NULL);
+            }
+        }
+        _chunk_wl[c] = chunk_wl;
+    });
+    if(g){
+        int num_module_chunks = (_num_modules + MODULE_CHUNK-1) / MODULE_CHUNK;
+        parallelRun(_pool, num_module_chunks, [&](int c){
+            for(int m = c*MODULE_CHUNK; m<min((c+1)*MODULE_CHUNK, _num_modules); m++){
+                double grad_x = 0., grad_y = 0.;
+                for(int k = _module_pin_start[m]; k<_module_pin_start[m+1]; k++){
+                    grad_x += _pin_grad[0][_module_pins[k]];
+                    grad_y += _pin_grad[1][_module_pins[k]];
+                }
+                (*g)[2*m] += grad_x;
+                (*g)[2*m+1] += grad_y;
+            }
+        });
+    }
+    double total_wl = 0.;
+    for(int c = 0; c<num_chunks; c++) total_wl += _chunk_wl[c];
+    return total_wl;
+}
+
+// wirelength of the coordinates in scratch.coord along one direction, with exponents, sums and
+// gradient in the same pass
+double WirelengthModel::netWirelength(Scratch &scratch, int num_pins, double *grad)
+{
+    const double *c = &scratch.coord[0];
+    double *e_max = &scratch.exp_max[0];
+    double *e_min = &scratch.exp_min[0];
+    double c_max = c[0];
+    double c_min = c[0];
+    for(int k = 1; k<num_pins; k++){
+        c_max = max(c_max, c[k]);
+        c_min = min(c_min, c[k]);
+    }
+    double inv_gamma = 1./_gamma;
+    double sum_max = 0., sum_min = 0.; // sum exp(+-x/gamma) scaled by the shift
+    double wsum_max = 0., wsum_min = 0.; // sum x*exp(+-x/gamma) scaled by the shift
+    for(int k = 0; k<num_pins; k++){
+        e_max[k] = exp((c[k] - c_max)*inv_gamma);
+        e_min[k] = exp((c_min - c[k])*inv_gamma);
+        sum_max += e_max[k];
+        sum_min += e_min[k];
+        wsum_max += c[k]*e_max[k];
+        wsum_min += c[k]*e_min[k];
+    }
+    double inv_max = 1./sum_max;
+    double inv_min = 1./sum_min;
+    if(_type == LSE){
+        if(grad){
+            for(int k = 0; k<num_pins; k++){
+                grad[k] = e_max[k]*inv_max - e_min[k]*inv_min;
+            }
+        }
+        return c_max - c_min + _gamma*(log(sum_max) + log(sum_min));
+    }
+    double wa_max = wsum_max*inv_max;
+    double wa_min = wsum_min*inv_min;
+    if(grad){
+        for(int k = 0; k<num_pins; k++){
+            grad[k] = e_max[k]*inv_max*(1. + (c[k] - wa_max)*inv_gamma)
+                    - e_min[k]*inv_min*(1. - (c[k] - wa_min)*inv_gamma);
+        }
+    }
+    return wa_max - wa_min;
+}
@@ -0,0 +1,59 @@
+#define _GLIBCXX_USE_CXX11_ABI 0
+#ifndef WIRELENGTHMODEL_H
+#define WIRELENGTHMODEL_H
+
+#include "Placement.h"
+#include "Parallel.h"
+#include <vector>
+
+using namespace std;
+
+// Smooth wirelength of nets with all pins at module centers, evaluated on a solution vector
+// with module mi center coordinate = (x[2*i], x[2*i+1]).
+// LSE: gamma*(log sum exp(x/gamma) + log sum exp(-x/gamma)) per net and direction
+// WA:  sum x*exp(x/gamma)/sum exp(x/gamma) - sum x*exp(-x/gamma)/sum exp(-x/gamma)
+// Exponents are shifted by the net maximum (minimum) so that no exp() overflows for any gamma.
+// With a thread pool, chunks of nets write per-pin gradients and partial sums, and chunks of
+// modules gather the gradients of their pins, so results do not depend on the number of threads.
+class WirelengthModel
+{
+public:
+    enum Type {LSE, WA};
+    WirelengthModel(Placement &placement, Type type, double gamma);
+    // nets in compressed rows: pins of net n are modules pin_module[net_start[n]..net_start[n+1])
+    WirelengthModel(const vector<int> &net_start, const vector<int> &pin_module, int num_modules, Type type, double gamma);
+    // wirelength, and its gradient added to g if not null
+    double evaluate(const vector<double> &x, vector<double> *g);
+    Type type() const {return _type;}
+    double gamma() const {return _gamma;}
+    void setGamma(double gamma) {_gamma = gamma;}
+    void setThreadPool(ThreadPool *pool) {_pool = pool;}
+    unsigned dimension() const {return 2*_num_modules;}
+    unsigned numNets() const {return _net_start.size()-1;}
+    unsigned numPins() const {return _pin_module.size();}
+
+private:
+    Type _type;
+    double _gamma;
+    int _num_modules;
+    ThreadPool *_pool; // not owned, serial if null
+    vector<int> _net_start;
+    vector<int> _pin_module;
+    // pins of module m are _module_pins[_module_pin_start[m].._module_pin_start[m+1])
+    vector<int> _module_pin_start;
+    vector<int> _module_pins;
+    // per-pin scratch of the net being evaluated, contiguous for vectorization, one per net chunk
+    struct Scratch
+    {
+        vector<double> coord;
+        vector<double> exp_max;
+        vector<double> exp_min;
+    };
+    vector<Scratch> _scratch;
+    vector<double> _chunk_wl;
+    vector<double> _pin_grad[2]; // gradient of every pin along x and y
+    void buildIndex();
+    double netWirelength(Scratch &scratch, int num_pins, double *grad);
+};
+
+#endif // WIRELENGTHMODEL_H
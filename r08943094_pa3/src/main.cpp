@@ -12,6 +12,9 @@
 #include <time.h>
 
 using namespace std;
+double macroTimeLimit = 0.; // seconds of macro pre-placement by the floorplanner, 0 for none
+const char *densityModel = NULL; // analytical global placement with this density model instead of SA
+bool nesterov = false; // Nesterov's method instead of conjugate gradient for the analytical placement
 bool handleArgument( const int& argc, char* argv[], CParamPlacement& param )
 {
 
@@ -44,8 +47,38 @@ bool handleArgument( const int& argc, char* argv[], CParamPlacement& param )
         else if( strcmp( argv[i]+1, "loadpl" ) == 0 ){
             param.plFilename = string( argv[++i] );
         }
+        else if( strcmp( argv[i]+1, "thread" ) == 0 && i+1 < argc ){
+            param.threadNum = atoi( argv[++i] );
+            if( param.threadNum < 1 ){
+                cout << "Number of threads has to be positive" << endl;
+                return false;
+            }
+        }
+        else if( strcmp( argv[i]+1, "macro" ) == 0 && i+1 < argc ){
+            macroTimeLimit = atof( argv[++i] );
+        }
+        else if( strcmp( argv[i]+1, "density" ) == 0 && i+1 < argc ){
+            densityModel = argv[++i];
+            if( strcmp( densityModel, "sigmoid" ) != 0 && strcmp( densityModel, "electrostatic" ) != 0 ){
+                cout << "Unknown density model " << densityModel << ", use sigmoid or electrostatic" << endl;
+                return false;
+            }
+        }
+        else if( strcmp( argv[i]+1, "optimizer" ) == 0 && i+1 < argc ){
+            const char *optimizer = argv[++i];
+            if( strcmp( optimizer, "cg" ) != 0 && strcmp( optimizer, "nesterov" ) != 0 ){
+                cout << "Unknown optimizer " << optimizer << ", use cg or nesterov" << endl;
+                return false;
+            }
+            nesterov = strcmp( optimizer, "nesterov" ) == 0;
+        }
         i++;
     }
+    // Nesterov stops at a density overflow, which only the electrostatic model measures
+    if( nesterov && ( !densityModel || strcmp( densityModel, "electrostatic" ) != 0 ) ){
+        cout << "-optimizer nesterov requires -density electrostatic" << endl;
+        return false;
+    }
     return true;
 }
 ///////////////////////////////////////////////////////////////////////////
@@ -94,8 +127,13 @@ int main(int argc, char *argv[])
         ////////////start to edit your code /////////////
 		
 		GlobalPlacer globalPlacer(placement);
-		// globalPlacer.place();
-        globalPlacer.SA_place();
+		if(macroTimeLimit > 0) globalPlacer.place_macros(macroTimeLimit);
+		if(densityModel){
+            globalPlacer.set_density_model(strcmp( densityModel, "electrostatic" ) == 0 ? ExampleFunction::ELECTROSTATIC : ExampleFunction::SIGMOID);
+            globalPlacer.set_nesterov(nesterov);
+            globalPlacer.place();
+        }
+        else globalPlacer.SA_place();
 		globalPlacer.plotPlacementResult( "init.plt" );
 
 		/////////////////////////////////////////////////